@@ -2,12 +2,101 @@
 #ifndef AI_H
 #define AI_H
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
 #include "board.h"
+#include "eval.h"
+#include "movegen.h"
+#include "tt.h"
+
+const int SEARCH_DEPTH = 4; // Plies searched from the root at the default strength level
+const int MAX_SEARCH_DEPTH = 64; // Iteration cap while a search is running without limits (pondering)
+const int MATE_SCORE = 30000;    // Score of being mated at the root; mate in n plies scores MATE_SCORE - n
+const int MATE_BOUND = MATE_SCORE - 1000; // Scores at least this far from zero are forced mates
+
+inline bool is_mate_score(int score) { return std::abs(score) >= MATE_BOUND; }
+// Moves until the side to move mates for a mate score, negative if it is the one being mated
+inline int mate_in_moves(int score) {
+    return (score > 0) ? (MATE_SCORE - score + 1) / 2 : -(MATE_SCORE + score) / 2;
+}
+
+/** Limits for one search; the search stops at whichever is reached first **/
+struct SearchLimits {
+    int depth = SEARCH_DEPTH;
+    uint64_t nodes = 0;  // 0 for no node limit
+    int moveTimeMs = 0;  // 0 for no time limit
+    int noiseCp = 0;     // Largest error added to leaf evaluations, for weaker play; 0 for none
+    uint64_t noiseSeed = 0; // Varies the noise between searches of the same position
+    int multiPv = 1;     // Root moves given exact scores and lines, best first
+};
+
+/** Difficulty levels. Weaker levels search fewer nodes, so they also cost proportionally less CPU, and
+    misjudge positions by up to noiseCp instead of searching fully and then throwing the result away. **/
+const int MIN_STRENGTH_LEVEL = 1;
+const int MAX_STRENGTH_LEVEL = 8;
+const int DEFAULT_STRENGTH_LEVEL = 7; // The fixed SEARCH_DEPTH search; level 8 searches deeper against the clock
+
+SearchLimits strength_limits(int level); // Levels outside the range are clamped
+
+struct SearchResult {
+    PackedMove bestMove = NO_MOVE;
+    int score = 0;       // Centipawns from the side to move's point of view
+    int depth = 0;       // Last completed iteration
+    uint64_t nodes = 0;
+    EvalStats evalStats; // Evaluation and pawn cache use during this search
+    std::vector<PackedMove> mateLine; // Filled in by the mate solver when the score is a forced mate
+};
+
+/** One principal variation of a multi-PV search **/
+struct AnalysisLine {
+    int score = 0;                // Centipawns from the side to move's point of view
+    std::vector<PackedMove> pv;   // Starts with the root move; the rest is read back from the table
+};
+
+/** The lines of the deepest completed iteration **/
+struct AnalysisInfo {
+    int depth = 0;
+    uint64_t nodes = 0;
+    std::vector<AnalysisLine> lines; // Best first, at most SearchLimits::multiPv of them
+};
+
+using IterationCallback = std::function<void(const AnalysisInfo&)>; // Called by the searching thread
+
+enum Engine { ENGINE_ALPHA_BETA, ENGINE_MCTS };
+
+/** Lets another thread steer a running search **/
+struct SearchControl {
+    std::atomic<bool> stop{false};       // Abort as soon as possible
+    std::atomic<bool> pondering{false};  // Ignore the limits until cleared by a ponder hit
+};
 
 int evaluate_board(const ChessBoard& board);
+int quiescence_score(ChessBoard& board); // Side to move's score once captures are resolved
 std::vector<std::pair<int, int>> generate_moves(const ChessBoard& board, int row, int col);
 int minimax(ChessBoard& board, int depth, bool isMaximizingPlayer, int alpha, int beta, int& moveCount);
+SearchResult search_best_move(ChessBoard& board, const SearchLimits& limits, TranspositionTable* tt = nullptr,
+                              SearchControl* control = nullptr, const IterationCallback& onIteration = nullptr);
 void make_best_move(ChessBoard& board);
+void set_engine(Engine engine, int threads = 1); // Engine used by make_best_move; threads apply to MCTS
+// Sizes the game's transposition table, or attaches it to a named shared memory segment so engine
+// processes on one host share results. Returns false if the segment cannot be opened.
+bool set_hash(size_t megabytes, const std::string& sharedName = "");
+bool load_hash_file(const std::string& path); // Warm-starts the game's table from a saved file
+bool save_hash_file(const std::string& path); // Saves the game table's deep entries for the next run
+void set_pondering(bool enabled); // Search the expected reply while the player thinks (on by default)
+// Background analysis of the GUI's position with several lines, sharing the game's table. While it is
+// enabled, update_analysis restarts it whenever the position changes, and the AI does not ponder.
+void set_analysis(bool enabled, int lines = 3);
+bool analysis_enabled();
+void update_analysis(const ChessBoard& board);
+AnalysisInfo analysis_info();
+void set_strength(int level);     // Level used by make_best_move; weaker than the default never ponders
+int get_strength();
+void stop_pondering();            // Call when the board changes other than by the player's move
 
 #endif // AI_H
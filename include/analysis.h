@@ -0,0 +1,40 @@
+/** Header File declaring the Analyzer, which searches the position on the screen in the background **/
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include "ai.h"
+#include "board.h"
+#include "tt.h"
+
+class Analyzer {
+public:
+    explicit Analyzer(TranspositionTable& tt) : tt(tt) {}
+    ~Analyzer() { stop(); }
+    Analyzer(const Analyzer&) = delete;
+    Analyzer& operator=(const Analyzer&) = delete;
+
+    // Searches the position with the given number of lines until stopped, deepening one iteration at a
+    // time. Keeps a running analysis of the same position; any other one is replaced.
+    void start(const ChessBoard& board, int lines);
+    void stop();
+    bool active() const { return thread.joinable(); }
+
+    // Lines of the deepest iteration finished so far; empty until the first one is
+    AnalysisInfo latest() const;
+
+private:
+    TranspositionTable& tt;
+    ChessBoard analysisBoard;
+    SearchControl control;
+    SearchLimits limits;
+    uint64_t analysisHash = 0;
+    size_t analysisPly = 0;
+    mutable std::mutex infoMutex;
+    AnalysisInfo info;
+    std::thread thread;
+};
+
+#endif // ANALYSIS_H
@@ -0,0 +1,149 @@
+/** Header File with Bitboard helpers, compile-time Attack Tables and the Magic/PEXT slider lookups **/
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <cstdint>
+#include "piece.h"
+
+// Squares are numbered row * 8 + col, matching ChessBoard::board[row][col] (row 0 is Black's back rank)
+typedef uint64_t Bitboard;
+
+constexpr Bitboard square_bb(int square) { return 1ULL << square; }
+inline int lsb(Bitboard b) { return __builtin_ctzll(b); }
+inline int msb(Bitboard b) { return 63 - __builtin_clzll(b); }
+inline int popcount(Bitboard b) { return __builtin_popcountll(b); }
+inline int pop_lsb(Bitboard& b) {
+    int square = lsb(b);
+    b &= b - 1;
+    return square;
+}
+
+constexpr Color opposite(Color color) { return color == WHITE ? BLACK : WHITE; }
+
+// Ray directions as (row, col) steps. The first four increase the square index, the last four decrease it.
+enum Direction { EAST, SOUTH_WEST, SOUTH, SOUTH_EAST, WEST, NORTH_EAST, NORTH, NORTH_WEST };
+constexpr int DIRECTION_ROW[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+constexpr int DIRECTION_COL[8] = { 1, -1, 0, 1, -1, 1, 0, -1 };
+
+struct AttackTables {
+    Bitboard knight[64];
+    Bitboard king[64];
+    Bitboard pawn[2][64];   // Squares attacked by a pawn of the given color
+    Bitboard rays[8][64];   // Squares along a direction up to the board edge
+    Bitboard between[64][64]; // Squares strictly between two aligned squares
+};
+
+constexpr bool on_board(int row, int col) { return row >= 0 && row < 8 && col >= 0 && col < 8; }
+
+constexpr AttackTables make_attack_tables() {
+    AttackTables t{};
+    const int knightRow[8] = { -2, -2, -1, -1, 1, 1, 2, 2 };
+    const int knightCol[8] = { -1, 1, -2, 2, -2, 2, -1, 1 };
+    for (int square = 0; square < 64; square++) {
+        int row = square / 8, col = square % 8;
+        for (int i = 0; i < 8; i++) {
+            if (on_board(row + knightRow[i], col + knightCol[i])) {
+                t.knight[square] |= square_bb((row + knightRow[i]) * 8 + col + knightCol[i]);
+            }
+            if (on_board(row + DIRECTION_ROW[i], col + DIRECTION_COL[i])) {
+                t.king[square] |= square_bb((row + DIRECTION_ROW[i]) * 8 + col + DIRECTION_COL[i]);
+            }
+            for (int r = row + DIRECTION_ROW[i], c = col + DIRECTION_COL[i]; on_board(r, c);
+                 r += DIRECTION_ROW[i], c += DIRECTION_COL[i]) {
+                t.rays[i][square] |= square_bb(r * 8 + c);
+            }
+        }
+        for (int side = -1; side <= 1; side += 2) {
+            if (on_board(row - 1, col + side)) t.pawn[WHITE][square] |= square_bb((row - 1) * 8 + col + side);
+            if (on_board(row + 1, col + side)) t.pawn[BLACK][square] |= square_bb((row + 1) * 8 + col + side);
+        }
+    }
+    for (int from = 0; from < 64; from++) {
+        for (int dir = 0; dir < 8; dir++) {
+            Bitboard path = 0;
+            for (int r = from / 8 + DIRECTION_ROW[dir], c = from % 8 + DIRECTION_COL[dir]; on_board(r, c);
+                 r += DIRECTION_ROW[dir], c += DIRECTION_COL[dir]) {
+                t.between[from][r * 8 + c] = path;
+                path |= square_bb(r * 8 + c);
+            }
+        }
+    }
+    return t;
+}
+
+inline constexpr AttackTables ATTACKS = make_attack_tables();
+
+/** Attacks along one ray, stopping at (and including) the first blocker **/
+template<Direction D>
+inline Bitboard ray_attacks(int square, Bitboard occupied) {
+    Bitboard attacks = ATTACKS.rays[D][square];
+    Bitboard blockers = attacks & occupied;
+    if (blockers) {
+        int blocker = (D < WEST) ? lsb(blockers) : msb(blockers);
+        attacks ^= ATTACKS.rays[D][blocker];
+    }
+    return attacks;
+}
+
+// Ray-by-ray slider attacks; used to build the lookup tables below and as a reference
+inline Bitboard bishop_attacks_classical(int square, Bitboard occupied) {
+    return ray_attacks<SOUTH_WEST>(square, occupied) | ray_attacks<SOUTH_EAST>(square, occupied) |
+           ray_attacks<NORTH_EAST>(square, occupied) | ray_attacks<NORTH_WEST>(square, occupied);
+}
+
+inline Bitboard rook_attacks_classical(int square, Bitboard occupied) {
+    return ray_attacks<EAST>(square, occupied) | ray_attacks<SOUTH>(square, occupied) |
+           ray_attacks<WEST>(square, occupied) | ray_attacks<NORTH>(square, occupied);
+}
+
+/** Slider lookup for one square: the occupancy that matters, and two indexings of the same attack sets **/
+struct SliderSquare {
+    Bitboard mask;                  // Rays from the square without their edge squares
+    Bitboard magic;                 // Multiplier that maps every masked occupancy to its own index
+    const Bitboard* magicAttacks;   // Indexed by ((occupied & mask) * magic) >> shift
+    const Bitboard* pextAttacks;    // Indexed by pext(occupied, mask)
+    int shift;
+};
+
+enum SliderMode { SLIDER_MAGIC, SLIDER_PEXT };
+
+struct SliderTables {
+    SliderSquare bishop[64];
+    SliderSquare rook[64];
+    SliderMode mode;                // PEXT where BMI2 is present and fast, magic multiplication otherwise
+};
+
+// Built during static initialization by src/bitboard.cpp, so attacks must not be looked up before main
+extern SliderTables SLIDERS;
+
+bool pext_supported();              // BMI2 is present (on some CPUs PEXT is microcoded and slow)
+bool set_slider_mode(SliderMode mode); // For benchmarks; false if the CPU lacks BMI2
+const char* slider_mode_name();
+
+/** Parallel bit extract. Emitted as an instruction on x86-64 even when the compiler does not target BMI2;
+    it is only reached once the CPU is known to support it. **/
+inline Bitboard pext(Bitboard bits, Bitboard mask) {
+#if defined(__x86_64__)
+    Bitboard result;
+    asm("pextq %2, %1, %0" : "=r"(result) : "r"(bits), "r"(mask));
+    return result;
+#else
+    (void)mask;
+    return bits; // Never selected without BMI2
+#endif
+}
+
+inline Bitboard slider_attacks(const SliderSquare& entry, Bitboard occupied) {
+    if (SLIDERS.mode == SLIDER_PEXT) return entry.pextAttacks[pext(occupied, entry.mask)];
+    return entry.magicAttacks[((occupied & entry.mask) * entry.magic) >> entry.shift];
+}
+
+inline Bitboard bishop_attacks(int square, Bitboard occupied) {
+    return slider_attacks(SLIDERS.bishop[square], occupied);
+}
+
+inline Bitboard rook_attacks(int square, Bitboard occupied) {
+    return slider_attacks(SLIDERS.rook[square], occupied);
+}
+
+#endif // BITBOARD_H
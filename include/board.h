@@ -4,7 +4,10 @@
 
 #include <vector>
 #include <string>
+#include <cstdint>
 #include "piece.h"
+#include "bitboard.h"
+#include "nnue.h"
 
 class ChessBoard {
 public:
@@ -25,6 +28,23 @@ public:
     bool blackKingsideRookMoved;
     bool blackQueensideRookMoved;
 
+    // For draw detection (threefold repetition and fifty-move rule)
+    Color sideToMove;
+    uint64_t hash;                          // Zobrist hash of the current position
+    int halfmoveClock;                      // Plies since the last capture or pawn move
+    int fullmoveNumber;                     // Starts at 1 and increases after each Black move
+    std::vector<uint64_t> positionHistory;  // Hashes of the positions before each move in moveHistory
+
+    // Bitboards mirroring the board, kept in sync by make_move/unmake_move
+    Bitboard pieceBB[2][6];
+    Bitboard colorBB[2];
+    Bitboard occupied() const { return colorBB[WHITE] | colorBB[BLACK]; }
+    int king_square(Color color) const { return lsb(pieceBB[color][KING]); }
+    void update_bitboards();
+
+    // First layer of the neural evaluator, updated incrementally when a network is loaded
+    mutable NnueAccumulator accumulator;
+
     const std::vector<Piece>& operator[](int index) const {
         return board[index];
     }
@@ -41,17 +61,48 @@ public:
         bool wasPawnPromotion;
         PieceType promotedTo;
 
+        // State before the move, restored on undo
+        int prevCastlingFlags;
+        int prevHalfmoveClock;
+        std::pair<int, int> prevLastMove;
+        std::pair<int, int> prevLastMoveStart;
+        bool prevLastMoveWasPawnDouble;
+
         Move(int sr, int sc, int dr, int dc, Piece captured, bool ep = false, bool castle = false, bool promotion = false, PieceType promo = EMPTY)
             : srcRow(sr), srcCol(sc), destRow(dr), destCol(dc), capturedPiece(captured),
-              wasEnPassant(ep), wasCastling(castle), wasPawnPromotion(promotion), promotedTo(promo) {}
+              wasEnPassant(ep), wasCastling(castle), wasPawnPromotion(promotion), promotedTo(promo),
+              prevCastlingFlags(0), prevHalfmoveClock(0), prevLastMove(-1, -1), prevLastMoveStart(-1, -1),
+              prevLastMoveWasPawnDouble(false) {}
     };
 
     std::vector<Move> moveHistory;
-    void record_move(int srcRow, int srcCol, int destRow, int destCol);
+    std::vector<Move> redoHistory;
+    void make_move(int srcRow, int srcCol, int destRow, int destCol, PieceType promotion = QUEEN);
+    void unmake_move();
     bool undo_last_move();
     bool redo_move();
     std::string move_to_string(const Move& move) const;
     std::vector<std::string> get_move_history_strings() const;
+
+    // FEN (Forsyth-Edwards Notation) import and export
+    bool load_fen(const std::string& fen);
+    std::string to_fen() const;
+
+    // Zobrist hashing and draw detection
+    uint64_t compute_hash() const;
+    int repetition_count() const;
+    bool is_fifty_move_draw() const;
+
+private:
+    int castling_flags() const;
+    int castling_rights() const;
+    void set_castling_flags(int flags);
+    int en_passant_file() const;
+    uint64_t state_key() const;
+    void set_square(int row, int col, Piece piece);
+    void clear_square(int row, int col);
+    void put_piece(int row, int col, Piece piece);
+    void remove_piece(int row, int col);
 };
 
 // Piece movement validity
@@ -68,6 +119,7 @@ std::vector<std::pair<int, int>> get_valid_moves(const ChessBoard& board, int ro
 bool is_check(const ChessBoard& board, Color color);
 bool is_checkmate(ChessBoard& board, Color color);
 bool is_stalemate(ChessBoard& board, Color color);
+bool has_insufficient_material(const ChessBoard& board);
 
 // Function declarations for castling logic
 bool is_castling_valid(const ChessBoard& board, int srcRow, int srcCol, int destRow, int destCol, Color color);
@@ -0,0 +1,46 @@
+/** Header File declaring the Evaluation Terms, the Pawn Structure score and the Evaluation Caches **/
+#ifndef EVAL_H
+#define EVAL_H
+
+#include <cstdint>
+#include "board.h"
+#include "eval_params.h"
+
+const int EVAL_CACHE_BITS = 16; // 64K full evaluations per thread
+const int PAWN_CACHE_BITS = 14; // 16K pawn structures per thread
+
+/** Cache counters; they are kept per thread, so concurrent searches do not share (or race on) them **/
+struct EvalStats {
+    uint64_t evalProbes = 0;
+    uint64_t evalHits = 0;
+    uint64_t pawnProbes = 0;
+    uint64_t pawnHits = 0;
+
+    double eval_hit_rate() const { return evalProbes ? (double)evalHits / evalProbes : 0.0; }
+    double pawn_hit_rate() const { return pawnProbes ? (double)pawnHits / pawnProbes : 0.0; }
+    EvalStats operator-(const EvalStats& other) const;
+    EvalStats& operator+=(const EvalStats& other);
+};
+
+/** How often each term of the material evaluation occurs, White's count minus Black's. The evaluation is
+    their sum weighted by eval_params.h, which is what tools/tune fits. **/
+struct EvalTerms {
+    int pieces[6] = {};      // By PieceType
+    int doubledPawns = 0;    // Pawns beyond the first on a file
+    int isolatedPawns = 0;
+    int passedPawns[8] = {}; // By relative rank (1 = starting rank; 0 and 7 unused)
+};
+
+EvalTerms evaluation_terms(const ChessBoard& board); // Uncached; for tools rather than the search
+uint64_t eval_params_hash(); // Identifies the compiled weights of eval_params.h across builds
+
+/** Doubled, isolated and passed pawns in centipawns from White's point of view, cached by pawn placement **/
+int evaluate_pawn_structure(const ChessBoard& board);
+
+/** Whole-evaluation cache keyed by Zobrist hash **/
+bool eval_cache_probe(uint64_t key, int& score);
+void eval_cache_store(uint64_t key, int score);
+
+const EvalStats& eval_stats(); // Totals for the calling thread since it started
+
+#endif // EVAL_H
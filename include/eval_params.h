@@ -0,0 +1,12 @@
+/** Header File holding the Material Evaluation's weights. Generated by tools/tune; regenerate rather than edit. **/
+#ifndef EVAL_PARAMS_H
+#define EVAL_PARAMS_H
+
+// Hand-set values, not yet fitted to a position set
+
+const int PIECE_VALUES[6] = { 0, 900, 500, 300, 300, 100 }; // By PieceType; kings are never traded
+const int DOUBLED_PAWN_PENALTY = 15;
+const int ISOLATED_PAWN_PENALTY = 15;
+const int PASSED_PAWN_BONUS[8] = { 0, 5, 10, 20, 35, 60, 100, 0 }; // By relative rank (1 = starting rank; 0 and 7 unused)
+
+#endif // EVAL_PARAMS_H
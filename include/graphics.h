@@ -16,6 +16,8 @@ void draw_valid_moves(SDL_Renderer* renderer, const std::vector<std::pair<int, i
 void draw_pieces(SDL_Renderer* renderer, const ChessBoard& board, const std::map<PieceType, SDL_Texture*>& white_pieces, const std::map<PieceType, SDL_Texture*>& black_pieces);
 void draw_button(SDL_Renderer* renderer, TTF_Font* font, int x, int y, int w, int h, const char* text);
 void draw_move_history(SDL_Renderer* renderer, TTF_Font* font, int x, int y, const ChessBoard& board);
+int draw_text_lines(SDL_Renderer* renderer, TTF_Font* font, int x, int y, const std::vector<std::string>& lines); // Returns the y below the last line
+void draw_eval_bar(SDL_Renderer* renderer, int x, int y, int w, int h, double whiteShare); // whiteShare from 0 (Black winning) to 1
 SDL_Texture* load_texture(SDL_Renderer* renderer, const char* file);
 
 #endif // GRAPHICS_H
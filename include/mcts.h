@@ -0,0 +1,65 @@
+/** Header File declaring the Monte Carlo Tree Search engine **/
+#ifndef MCTS_H
+#define MCTS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "ai.h"
+#include "board.h"
+#include "movegen.h"
+
+const uint64_t MCTS_DEFAULT_PLAYOUTS = 20000; // Budget when the limits give neither nodes nor time
+
+struct MctsOptions {
+    int threads = 1;             // Workers descending the shared tree
+    double exploration = 1.5;    // PUCT constant
+    int playoutPlies = 0;        // 0 to value leaves by quiescence search, else random plies played first
+    size_t maxNodes = 1 << 20;   // Arena capacity; once full, leaves are evaluated but not expanded
+};
+
+/** One tree node; children of a node are contiguous in the arena **/
+struct MctsNode {
+    std::atomic<int32_t> visits{0};
+    std::atomic<int64_t> valueSum{0};    // Fixed point, for the side that made `move`
+    std::atomic<uint32_t> firstChild{0};
+    std::atomic<uint16_t> childCount{0};
+    std::atomic<uint8_t> state{0};       // MctsNodeState
+    PackedMove move = NO_MOVE;
+    float prior = 0.0f;
+};
+
+/** Arena-allocated search tree that keeps the subtree of the moves actually played between searches **/
+class MctsTree {
+public:
+    explicit MctsTree(size_t maxNodes = MctsOptions().maxNodes);
+
+    // Makes the node for board's position the root, keeping its subtree when board is one or two
+    // moves past the previous root; otherwise starts a new tree
+    void set_root(const ChessBoard& board);
+    void clear();
+
+    size_t size() const { return used.load(); }
+    size_t capacity() const { return nodeCapacity; }
+
+private:
+    friend class MctsSearch;
+
+    uint32_t allocate(uint32_t count); // Index of the first of count nodes, 0 if the arena is full
+    void compact(uint32_t newRoot);
+
+    size_t nodeCapacity;
+    std::unique_ptr<MctsNode[]> nodes;
+    std::unique_ptr<MctsNode[]> spare;   // Compaction target, swapped with nodes afterwards
+    std::atomic<uint32_t> used{0};
+    uint32_t root = 0;
+    ChessBoard rootBoard;
+    bool hasRoot = false;
+};
+
+/** Searches the side to move's position with MCTS within the limits; nodes counts playouts **/
+SearchResult mcts_search(ChessBoard& board, const SearchLimits& limits, MctsTree& tree,
+                         const MctsOptions& options = MctsOptions(), SearchControl* control = nullptr);
+
+#endif // MCTS_H
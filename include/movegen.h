@@ -0,0 +1,66 @@
+/** Header File declaring Color-specialized Move Generation and Attack Queries **/
+#ifndef MOVEGEN_H
+#define MOVEGEN_H
+
+#include <cstdint>
+#include "board.h"
+#include "bitboard.h"
+
+// Compact move encoding used by the search: source square, destination square and promotion piece
+typedef uint16_t PackedMove;
+const PackedMove NO_MOVE = 0;
+
+inline PackedMove pack_move(int src, int dest, PieceType promotion = EMPTY) {
+    return (PackedMove)(src | (dest << 6) | ((promotion == EMPTY ? 0 : promotion) << 12));
+}
+inline int move_src(PackedMove move) { return move & 63; }
+inline int move_dest(PackedMove move) { return (move >> 6) & 63; }
+inline PieceType move_promotion(PackedMove move) { return (move >> 12) ? (PieceType)(move >> 12) : EMPTY; }
+
+struct MoveList {
+    PackedMove moves[256];
+    int size = 0;
+
+    void add(PackedMove move) { moves[size++] = move; }
+    bool empty() const { return size == 0; }
+    const PackedMove* begin() const { return moves; }
+    const PackedMove* end() const { return moves + size; }
+};
+
+/** Pieces of color Them attacking a square, given an occupancy **/
+template<Color Them>
+inline Bitboard attackers_to(const ChessBoard& board, int square, Bitboard occupied) {
+    constexpr Color Us = opposite(Them);
+    const Bitboard* them = board.pieceBB[Them];
+    return (ATTACKS.pawn[Us][square] & them[PAWN]) |
+           (ATTACKS.knight[square] & them[KNIGHT]) |
+           (ATTACKS.king[square] & them[KING]) |
+           (bishop_attacks(square, occupied) & (them[BISHOP] | them[QUEEN])) |
+           (rook_attacks(square, occupied) & (them[ROOK] | them[QUEEN]));
+}
+
+template<Color Us>
+inline bool in_check(const ChessBoard& board) {
+    return attackers_to<opposite(Us)>(board, board.king_square(Us), board.occupied()) != 0;
+}
+
+// Move generation stages: captures and queen promotions first, then everything else
+enum GenType { CAPTURES, QUIETS, ALL };
+
+template<Color Us> bool is_legal(const ChessBoard& board, PackedMove move);
+template<Color Us> bool is_pseudo_legal(const ChessBoard& board, PackedMove move);
+template<Color Us, GenType Type> void generate_pseudo_moves(const ChessBoard& board, MoveList& list);
+template<Color Us> void generate_legal_moves(const ChessBoard& board, MoveList& list);
+void generate_legal_moves(const ChessBoard& board, MoveList& list); // For the side to move
+template<Color Us> void generate_legal_moves_to(const ChessBoard& board, PieceType type, int dest, MoveList& list);
+void generate_legal_moves_to(const ChessBoard& board, PieceType type, int dest, MoveList& list); // For the side to move
+
+inline void make_move(ChessBoard& board, PackedMove move) {
+    int src = move_src(move), dest = move_dest(move);
+    PieceType promotion = move_promotion(move);
+    board.make_move(src / 8, src % 8, dest / 8, dest % 8, promotion == EMPTY ? QUEEN : promotion);
+}
+
+uint64_t perft(ChessBoard& board, int depth);
+
+#endif // MOVEGEN_H
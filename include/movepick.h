@@ -0,0 +1,38 @@
+/** Header File declaring the staged Move Picker used inside the search tree **/
+#ifndef MOVEPICK_H
+#define MOVEPICK_H
+
+#include "board.h"
+#include "movegen.h"
+
+/** Captures and queen promotions; these are searched before killers and never stored as killers **/
+bool is_tactical(const ChessBoard& board, PackedMove move);
+
+/** Yields the legal moves of a node lazily, generating each stage only once the previous one is
+    exhausted: the table move, captures that do not lose material (by MVV-LVA), the killer moves, the
+    remaining quiet moves, then the losing captures. Cut nodes usually stop after the first stage or two. **/
+template<Color Us>
+class MovePicker {
+public:
+    MovePicker(const ChessBoard& board, PackedMove ttMove, const PackedMove killers[2]);
+    explicit MovePicker(const ChessBoard& board); // Quiescence: only captures that do not lose material
+    PackedMove next(); // NO_MOVE once every move of the requested kind has been returned
+
+private:
+    enum Stage { TT_MOVE, GENERATE_CAPTURES, PICK_CAPTURES, KILLERS, GENERATE_QUIETS, PICK_QUIETS, PICK_BAD_CAPTURES, DONE };
+
+    bool already_tried(PackedMove move) const;
+
+    const ChessBoard& board;
+    PackedMove ttMove;
+    PackedMove killers[2];
+    int stage = TT_MOVE;
+    bool quiescence = false;
+    int killerIndex = 0;
+    int current = 0;
+    MoveList moves;
+    int scores[256];
+    MoveList badCaptures;        // Captures that lose material by static exchange, tried last
+};
+
+#endif // MOVEPICK_H
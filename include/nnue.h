@@ -0,0 +1,38 @@
+/** Header File declaring the optional Neural Network Evaluator (NNUE) **/
+#ifndef NNUE_H
+#define NNUE_H
+
+#include <cstdint>
+#include <string>
+#include "piece.h"
+
+class ChessBoard;
+
+// Network shape: 768 piece-square inputs -> NNUE_HIDDEN per perspective -> 1 output
+const int NNUE_INPUTS = 2 * 6 * 64;
+const int NNUE_HIDDEN = 256;
+
+// Quantization: feature weights are int16 scaled by NNUE_QA, output weights int8 scaled by NNUE_QB.
+// Hidden activations are clipped to [0, NNUE_QA] so they fit in a uint8.
+const int NNUE_QA = 127;
+const int NNUE_QB = 64;
+const int NNUE_OUTPUT_SCALE = 400; // Centipawns per unit of network output
+
+/** First-layer sums for both perspectives, updated as pieces are added and removed **/
+struct NnueAccumulator {
+    alignas(32) int16_t values[2][NNUE_HIDDEN];
+    uint32_t network = 0; // Id of the network the values belong to, 0 if they need a refresh
+};
+
+bool nnue_load(const std::string& path);
+bool nnue_enabled();
+uint32_t nnue_network_id();
+uint64_t nnue_network_checksum(); // Identifies the loaded weights across runs; 0 without a network
+const char* nnue_kernel_name();
+
+void nnue_add_piece(NnueAccumulator& accumulator, Piece piece, int square);
+void nnue_remove_piece(NnueAccumulator& accumulator, Piece piece, int square);
+void nnue_refresh(const ChessBoard& board, NnueAccumulator& accumulator);
+int nnue_evaluate(const ChessBoard& board); // Centipawns, from the side to move's point of view
+
+#endif // NNUE_H
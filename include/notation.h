@@ -0,0 +1,18 @@
+/** Header File declaring Move Notation helpers (coordinate and SAN) **/
+#ifndef NOTATION_H
+#define NOTATION_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "board.h"
+#include "movegen.h"
+
+std::string square_to_string(int square);
+std::string move_to_uci(PackedMove move);
+std::string move_to_san(ChessBoard& board, PackedMove move);
+std::string line_to_san(const ChessBoard& board, const std::vector<PackedMove>& line); // Space separated
+PackedMove parse_uci_move(const ChessBoard& board, const std::string& text); // NO_MOVE if not legal
+PackedMove parse_san(const ChessBoard& board, std::string_view san);        // NO_MOVE if not legal or ambiguous
+
+#endif // NOTATION_H
@@ -0,0 +1,77 @@
+/** Header File declaring the PGN Reader and the on-disk Game Index **/
+#ifndef PGN_H
+#define PGN_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "board.h"
+#include "mapped_file.h"
+
+enum PgnResult : uint8_t { RESULT_UNKNOWN, RESULT_WHITE_WINS, RESULT_BLACK_WINS, RESULT_DRAW };
+
+/** Location of one game inside a PGN file **/
+struct PgnGameSpan {
+    uint64_t offset;
+    uint64_t length;
+};
+
+/** Outcome of replaying one game's movetext **/
+struct PgnGameInfo {
+    PgnResult result = RESULT_UNKNOWN;
+    int plies = 0;               // Moves replayed, up to the first one that failed to parse
+    bool ok = false;             // False if the start position or a move could not be parsed
+    std::string error;           // The offending FEN or SAN token when !ok
+};
+
+/** One fixed-size index record; the game's position hashes are hashes[firstHash .. firstHash + plies] **/
+struct PgnIndexEntry {
+    uint64_t offset;
+    uint64_t firstHash;
+    uint32_t length;
+    uint16_t plies;
+    uint8_t result;              // PgnResult
+    uint8_t flags;               // PGN_INDEX_PARSE_ERROR if the game was only partly replayed
+};
+
+const uint8_t PGN_INDEX_PARSE_ERROR = 1;
+
+/** Splits a PGN buffer into games without parsing them; each game starts at its first tag line **/
+void scan_pgn_games(const char* data, size_t size, std::vector<PgnGameSpan>& games);
+
+/** Replays one game (tags and movetext) onto board, which is reset first. Hashes of every position
+    from the start through the last replayed move are appended to hashes when it is not null. **/
+bool replay_pgn_game(std::string_view text, ChessBoard& board, PgnGameInfo& info, std::vector<uint64_t>* hashes = nullptr);
+
+/** Zero-copy view of an index file written by PgnIndexWriter **/
+class PgnIndex {
+public:
+    bool open(const std::string& path);
+
+    size_t size() const { return gameCount; }
+    const PgnIndexEntry& game(size_t i) const { return entries[i]; }
+    const uint64_t* hashes(size_t i) const { return allHashes + entries[i].firstHash; }
+
+private:
+    MappedFile file;
+    const PgnIndexEntry* entries = nullptr;
+    const uint64_t* allHashes = nullptr;
+    uint64_t gameCount = 0;
+};
+
+/** Writes an index in game order: header, one entry per game, then all position hashes **/
+class PgnIndexWriter {
+public:
+    bool open(const std::string& path, uint64_t games);
+    void add(const PgnGameSpan& span, const PgnGameInfo& info, const uint64_t* hashes, size_t count);
+    bool finish(); // Writes the entry table once every game has been added
+
+private:
+    std::ofstream out;
+    std::vector<PgnIndexEntry> entries;
+    uint64_t hashCount = 0;
+};
+
+#endif // PGN_H
@@ -0,0 +1,37 @@
+/** Header File declaring the proof-number mate solver **/
+#ifndef PNS_H
+#define PNS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ai.h"
+#include "board.h"
+#include "movegen.h"
+
+const size_t PNS_DEFAULT_MB = 16;
+const uint64_t PNS_DEFAULT_NODES = 1000000;
+const int MAX_PNS_PLY = 256; // Lines longer than this are treated as failing to mate
+
+struct MateSolverOptions {
+    uint64_t nodes = PNS_DEFAULT_NODES; // Positions expanded before giving up
+    size_t hashMb = PNS_DEFAULT_MB;     // Size of the solver's own table, its only other memory use
+    bool checksOnly = false;            // Only consider checking moves for the mating side (much faster, may miss quiet mates)
+};
+
+enum MateStatus { MATE_UNKNOWN, MATE_PROVEN, MATE_DISPROVEN };
+
+struct MateResult {
+    MateStatus status = MATE_UNKNOWN;   // Disproven means the side to move has no forced mate
+    int mateIn = 0;                     // Moves until mate along the line when proven
+    std::vector<PackedMove> line;       // Mating line, attacker and defender moves alternating
+    uint64_t nodes = 0;
+};
+
+// Searches for a forced mate by the side to move with depth-first proof-number search. The line
+// plays the shortest mate the solver proved against the longest defense it considered, which is
+// not necessarily the shortest mate in the position.
+MateResult solve_mate(const ChessBoard& board, const MateSolverOptions& options = MateSolverOptions(),
+                      SearchControl* control = nullptr);
+
+#endif // PNS_H
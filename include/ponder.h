@@ -0,0 +1,41 @@
+/** Header File declaring the Ponderer, which searches on the opponent's time **/
+#ifndef PONDER_H
+#define PONDER_H
+
+#include <cstdint>
+#include <thread>
+#include "ai.h"
+#include "board.h"
+#include "tt.h"
+
+class Ponderer {
+public:
+    explicit Ponderer(TranspositionTable& tt) : tt(tt) {}
+    ~Ponderer() { stop(); }
+    Ponderer(const Ponderer&) = delete;
+    Ponderer& operator=(const Ponderer&) = delete;
+
+    // Predicts the opponent's reply from the table and searches the resulting position in the
+    // background. Returns false if there is no prediction.
+    bool start(const ChessBoard& board, const SearchLimits& limits);
+
+    // Call once the opponent has moved. On a ponder hit the running search continues under its
+    // normal limits and its result is returned; on a miss the search is abandoned.
+    bool finish(const ChessBoard& board, SearchResult& result);
+
+    void stop();
+    bool active() const { return thread.joinable(); }
+    PackedMove expected_move() const { return expected; }
+
+private:
+    TranspositionTable& tt;
+    ChessBoard ponderBoard;
+    SearchControl control;
+    SearchLimits limits;
+    SearchResult ponderResult;
+    uint64_t ponderHash = 0;
+    PackedMove expected = NO_MOVE;
+    std::thread thread;
+};
+
+#endif // PONDER_H
@@ -0,0 +1,15 @@
+/** Header File declaring Static Exchange Evaluation **/
+#ifndef SEE_H
+#define SEE_H
+
+#include "board.h"
+#include "movegen.h"
+
+// Exchange values in centipawns, indexed by PieceType; the king outweighs any exchange
+const int SEE_VALUES[] = { 20000, 900, 500, 300, 300, 100, 0 };
+
+/** Material won (or lost, if negative) by the side making the move once every profitable recapture
+    on the destination square has been played out, including x-ray attackers behind the first ones **/
+int see(const ChessBoard& board, PackedMove move);
+
+#endif // SEE_H
@@ -0,0 +1,88 @@
+/** Header File declaring the Session Server, which hosts many independent games behind a line protocol **/
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ai.h"
+#include "board.h"
+#include "thread_pool.h"
+
+const int SESSION_DEFAULT_MOVETIME_MS = 100;
+const size_t SESSION_LATENCY_SAMPLES = 100000; // Most recent AI moves kept for the percentiles
+
+struct SessionServerOptions {
+    int workers = ThreadPool::default_threads(); // Searches running at once
+    size_t maxQueued = 256;       // Searches waiting for a worker; beyond this requests are refused
+    size_t maxSessions = 100000;
+    int defaultMoveTimeMs = SESSION_DEFAULT_MOVETIME_MS;
+    int maxMoveTimeMs = 10000;    // Upper bound on the budget a client may ask for
+};
+
+/** One hosted game. The board is only changed under the server's lock; searches run on a copy. **/
+struct Session {
+    ChessBoard board;
+    int moveTimeMs = SESSION_DEFAULT_MOVETIME_MS;
+    int level = 0;             // Strength level; 0 searches for the whole time budget at full strength
+    bool searching = false;
+    SearchControl control;
+};
+
+struct LatencyReport {
+    uint64_t moves = 0;     // AI moves answered since the server started
+    double p50Ms = 0;
+    double p99Ms = 0;
+    double maxMs = 0;
+};
+
+/** Requests, one per line (every reply is one line starting with its kind and the session id):
+      new [MOVETIME_MS] [FEN]   -> ok ID
+      move ID MOVE              -> ok ID RESULT          (coordinate or SAN move for the side to move)
+      go ID                     -> bestmove ID MOVE SCORE MS, later, from a worker
+      level ID N                -> ok ID                 (strength 1-8 for later searches, see strength_limits)
+      state ID                  -> state ID RESULT FEN
+      end ID                    -> ok ID
+      stats                     -> stats sessions N searching N moves N p50 MS p99 MS max MS
+    RESULT is *, 1-0, 0-1 or 1/2-1/2. Failures reply "error ID REASON"; a full search queue replies
+    "error ID busy" so clients back off instead of piling up work. **/
+class SessionServer {
+public:
+    using Reply = std::function<void(const std::string&)>; // May be called from a worker thread
+
+    explicit SessionServer(const SessionServerOptions& options = SessionServerOptions());
+    ~SessionServer();
+    SessionServer(const SessionServer&) = delete;
+    SessionServer& operator=(const SessionServer&) = delete;
+
+    void handle(const std::string& request, const Reply& reply);
+    LatencyReport latency() const;
+    size_t session_count() const;
+
+private:
+    std::string new_session(std::istringstream& args);
+    std::string make_player_move(uint64_t id, const std::string& text);
+    std::string start_search(uint64_t id, const Reply& reply);
+    std::string set_level(uint64_t id, int level);
+    std::string describe(uint64_t id);
+    std::string end_session(uint64_t id);
+    std::string stats();
+    void record_latency(double milliseconds);
+
+    SessionServerOptions options;
+    mutable std::mutex mutex;
+    std::unordered_map<uint64_t, std::shared_ptr<Session>> sessions;
+    uint64_t nextId = 1;
+    size_t searching = 0;
+    std::vector<float> latencies; // Ring buffer of the most recent AI move latencies
+    uint64_t movesAnswered = 0;
+    ThreadPool pool;              // Declared last: destroyed first, so queued searches finish while the rest is alive
+};
+
+#endif // SESSION_H
@@ -0,0 +1,40 @@
+/** Header File declaring a fixed-size Thread Pool for the headless tools **/
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+    // maxQueued bounds the number of waiting tasks (0 for unbounded); submit blocks while it is full
+    explicit ThreadPool(int threads, size_t maxQueued = 0);
+    ~ThreadPool();
+
+    void submit(std::function<void()> task);
+    bool try_submit(std::function<void()> task); // false instead of blocking when the queue is full
+    void wait();                                 // Blocks until every submitted task has finished
+    int size() const { return (int)workers.size(); }
+
+    static int default_threads();
+
+private:
+    void worker_loop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    std::condition_variable spaceAvailable;
+    std::condition_variable allDone;
+    size_t maxQueued;
+    size_t running = 0;
+    bool stopping = false;
+};
+
+#endif // THREAD_POOL_H
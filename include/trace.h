@@ -0,0 +1,69 @@
+/** Header File declaring the Search Trace Recorder, which logs search tree events to a binary file **/
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "movegen.h"
+
+const char TRACE_FILE_MAGIC[8] = { 'C', 'H', 'S', 'T', 'R', 'A', 'C', 'E' };
+const uint32_t TRACE_FILE_VERSION = 1;
+const size_t TRACE_BUFFER_RECORDS = 1 << 16; // Per thread; a full buffer is written out as one block
+
+enum TraceEvent : uint8_t {
+    TRACE_SEARCH,     // A search starts: depth is the depth limit, key the position
+    TRACE_ITERATION,  // An iterative deepening iteration starts at the root
+    TRACE_ENTER,      // Alpha-beta node: ply, remaining depth, alpha, beta, key
+    TRACE_QUIESCE,    // Quiescence node: score is the static evaluation
+    TRACE_TT_HIT,     // The node ended on a stored result: depth is the entry's, score its score
+    TRACE_MOVE,       // A move is about to be searched: index is its place in the node's move order
+    TRACE_CUTOFF,     // The move just searched failed high
+    TRACE_EXIT,       // The node's result: score, index holds the Bound
+};
+
+/** One event, 16 bytes. Scores are clamped to 16 bits, which keeps mate scores intact. **/
+struct TraceRecord {
+    uint8_t event;
+    uint8_t ply;
+    int8_t depth;
+    uint8_t index;
+    uint16_t move;
+    int16_t score;
+    int16_t alpha;
+    int16_t beta;
+    uint32_t key;    // Low half of the position hash
+};
+
+/** The file is this header followed by blocks: a TraceBlock, then its records, all from one thread
+    and in order. Blocks of different threads interleave. **/
+struct TraceFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+};
+
+struct TraceBlock {
+    uint32_t thread;
+    uint32_t count;
+};
+
+// Starts writing every thread's events to the file. Each thread's buffer is written out when it fills
+// and when its search ends; events still buffered by another thread when tracing stops are dropped.
+bool trace_start(const std::string& path);
+void trace_stop();
+void trace_record(TraceEvent event, int ply, int depth, int index, PackedMove move, int score, int alpha, int beta,
+                  uint64_t key);
+void trace_flush_thread();
+
+extern std::atomic<bool> traceActive;
+
+// Build with -DCHESS_NO_TRACE to compile the hooks out; otherwise a disabled recorder costs one
+// well-predicted branch per event
+#ifdef CHESS_NO_TRACE
+#define TRACE(...) ((void)0)
+#else
+#define TRACE(...) do { if (traceActive.load(std::memory_order_relaxed)) trace_record(__VA_ARGS__); } while (0)
+#endif
+
+#endif // TRACE_H
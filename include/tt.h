@@ -0,0 +1,62 @@
+/** Header File declaring the Transposition Table shared by successive searches **/
+#ifndef TT_H
+#define TT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "movegen.h"
+
+const size_t TT_DEFAULT_MB = 16;
+const int TT_SAVE_MIN_DEPTH = 3; // Shallower entries are cheap to recompute and not worth saving
+
+enum Bound : uint8_t { BOUND_NONE, BOUND_UPPER, BOUND_LOWER, BOUND_EXACT };
+
+struct TTEntry {
+    uint64_t key;        // Full Zobrist hash, so index collisions are detected
+    int32_t score;       // Centipawns from the side to move's point of view
+    PackedMove move;     // Best or refuting move found, NO_MOVE if none
+    int8_t depth;        // Remaining depth the score was searched to
+    uint8_t bound;       // Bound
+};
+
+struct TTSlot;
+
+/** Lock-free table: each slot is two words, the key stored XORed with the data, so a slot torn by
+    a concurrent writer (another thread, or another process sharing the memory) reads as a miss **/
+class TranspositionTable {
+public:
+    explicit TranspositionTable(size_t megabytes = TT_DEFAULT_MB);
+    ~TranspositionTable();
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    void resize(size_t megabytes); // Rounds down to a power of two entries and clears the table
+    // Attaches to the named POSIX shared memory segment, creating it with the given size if it does
+    // not exist yet; an existing segment keeps its size and contents. The segment outlives the process
+    // so later games start warm; remove it with unlink_shared. Prints the reason and returns false on failure.
+    bool open_shared(const std::string& name, size_t megabytes = TT_DEFAULT_MB);
+    static bool unlink_shared(const std::string& name);
+    bool is_shared() const { return shared; }
+    // Writes the entries searched to at least minDepth to a compact file, tagged with the evaluation
+    // that produced their scores. Prints the reason and returns false on failure.
+    bool save(const std::string& path, uint64_t evalTag, int minDepth = TT_SAVE_MIN_DEPTH) const;
+    // Maps a saved file and stores its entries. Files of another version or evaluation, or that fail
+    // the checksum, are rejected. Prints the outcome and returns false if nothing was loaded.
+    bool load(const std::string& path, uint64_t evalTag);
+    void clear();        // Also clears the table for every process sharing it
+    bool probe(uint64_t key, TTEntry& entry) const;
+    void store(uint64_t key, int depth, int score, Bound bound, PackedMove move);
+    size_t size() const { return count; }
+
+private:
+    void release();
+
+    TTSlot* entries = nullptr;
+    size_t count = 0;
+    size_t mappedBytes = 0;
+    uint64_t mask = 0;
+    bool shared = false;
+};
+
+#endif // TT_H
@@ -1,149 +1,556 @@
 #include "ai.h"
 #include "board.h"
+#include "movegen.h"
+#include "movepick.h"
+#include "nnue.h"
+#include "notation.h"
+#include "analysis.h"
+#include "mcts.h"
+#include "pns.h"
+#include "ponder.h"
+#include "trace.h"
 #include <algorithm>
+#include <chrono>
 #include <vector>
 #include <iostream>
 #include <limits>
 
 const int NUM_TILES = 8;
-const int ALPHA_INITIAL = std::numeric_limits<int>::min();
+const int ALPHA_INITIAL = -std::numeric_limits<int>::max(); // Symmetric so negamax can negate it
 const int BETA_INITIAL = std::numeric_limits<int>::max();
-const int SEARCH_DEPTH = 3; // The search depth TODO: make this variable for difficulty control
-const int MAX_MOVES = 100; // To prevent infinite loops
+const int MAX_QUIESCENCE_PLY = 2 * MAX_SEARCH_DEPTH; // Safety net; capture sequences end long before this
+const uint64_t MATE_SOLVER_NODES = 200000; // Budget for finding the mating line once the search sees a mate
+const size_t MATE_SOLVER_MB = 4;
 
-/** Score Evaluation Function **/
+struct StrengthSettings {
+    int depth;
+    uint64_t nodes;
+    int moveTimeMs;
+    int noiseCp;
+};
+
+// Node budgets set the CPU cost of the weak levels; the time budgets only guard against slow positions
+static const StrengthSettings STRENGTH_LEVELS[MAX_STRENGTH_LEVEL] = {
+    { 1,                150,     20, 250 },
+    { 2,                600,     40, 150 },
+    { 2,                2500,    80, 100 },
+    { 3,                10000,   150, 60 },
+    { 3,                40000,   300, 40 },
+    { 3,                150000,  400, 10 },
+    { SEARCH_DEPTH,     0,       0,   0 },
+    { MAX_SEARCH_DEPTH, 0,       3000, 0 },
+};
+
+SearchLimits strength_limits(int level) {
+    const StrengthSettings& settings = STRENGTH_LEVELS[std::min(std::max(level, MIN_STRENGTH_LEVEL), MAX_STRENGTH_LEVEL) - 1];
+    SearchLimits limits;
+    limits.depth = settings.depth;
+    limits.nodes = settings.nodes;
+    limits.moveTimeMs = settings.moveTimeMs;
+    limits.noiseCp = settings.noiseCp;
+    return limits;
+}
+
+/** Material of one side in centipawns, using the piece bitboards **/
+template<Color Us>
+static int material(const ChessBoard& board) {
+    const Bitboard* pieces = board.pieceBB[Us];
+    return PIECE_VALUES[PAWN] * popcount(pieces[PAWN]) + PIECE_VALUES[KNIGHT] * popcount(pieces[KNIGHT]) +
+           PIECE_VALUES[BISHOP] * popcount(pieces[BISHOP]) + PIECE_VALUES[ROOK] * popcount(pieces[ROOK]) +
+           PIECE_VALUES[QUEEN] * popcount(pieces[QUEEN]);
+}
+
+/** Score Evaluation Function, in centipawns from White's point of view **/
 int evaluate_board(const ChessBoard& board) {
-    int score = 0;
-    for (const auto& row : board.board) {
-        for (const auto& piece : row) {
-            if (piece.color == WHITE) {
-                if (piece.type == PAWN) score += 1;
-                if (piece.type == KNIGHT || piece.type == BISHOP) score += 3;
-                if (piece.type == ROOK) score += 5;
-                if (piece.type == QUEEN) score += 9;
-            } else if (piece.color == BLACK) {
-                if (piece.type == PAWN) score -= 1;
-                if (piece.type == KNIGHT || piece.type == BISHOP) score -= 3;
-                if (piece.type == ROOK) score -= 5;
-                if (piece.type == QUEEN) score -= 9;
-            }
-        }
+    // Loading another network changes every score, so the network is part of the cache key
+    uint64_t key = board.hash ^ (nnue_network_id() * 0x9E3779B97F4A7C15ULL);
+    int score;
+    if (eval_cache_probe(key, score)) return score;
+
+    if (nnue_enabled()) {
+        score = nnue_evaluate(board);
+        score = (board.sideToMove == WHITE) ? score : -score;
+    } else {
+        score = material<WHITE>(board) - material<BLACK>(board) + evaluate_pawn_structure(board);
     }
+    eval_cache_store(key, score);
     return score;
 }
 
 /** Function to generate moves for a piece at (row, col) **/
 std::vector<std::pair<int, int>> generate_moves(const ChessBoard& board, int row, int col) {
     std::vector<std::pair<int, int>> moves;
-    for (int destRow = 0; destRow < NUM_TILES; destRow++) {
-        for (int destCol = 0; destCol < NUM_TILES; destCol++) {
-            if (is_valid_move(board, row, col, destRow, destCol, board.board[row][col].color)) {
-                moves.push_back({destRow, destCol});
-            }
+    int square = row * NUM_TILES + col;
+    MoveList legalMoves;
+    if (board.board[row][col].color == WHITE) {
+        generate_legal_moves<WHITE>(board, legalMoves);
+    } else if (board.board[row][col].color == BLACK) {
+        generate_legal_moves<BLACK>(board, legalMoves);
+    }
+    for (PackedMove move : legalMoves) {
+        // Underpromotions share a destination with the queen promotion
+        if (move_src(move) == square && (move_promotion(move) == EMPTY || move_promotion(move) == QUEEN)) {
+            moves.push_back({move_dest(move) / NUM_TILES, move_dest(move) % NUM_TILES});
         }
     }
     return moves;
 }
 
-/** Minimax with Alpha-Beta Pruning Algorithm **/
+/** Per-search state threaded through the recursion **/
+struct SearchContext {
+    SearchLimits limits;
+    std::chrono::steady_clock::time_point startTime;
+    uint64_t nodes = 0;
+    bool stopped = false;
+    int rootDepth = 0;                 // Depth of the current iteration
+    bool rootMoveNeeded = false;       // Limits wait until the root has a move, however small the budget
+    PackedMove killers[MAX_SEARCH_DEPTH + 1][2] = {}; // Quiet moves that caused cutoffs, by ply
+    PackedMove pv[MAX_SEARCH_DEPTH + 2][MAX_SEARCH_DEPTH + 2]; // Best line found below each ply so far
+    int pvLength[MAX_SEARCH_DEPTH + 2] = {};
+    TranspositionTable* tt = nullptr;  // Optional, kept between searches by the caller
+    SearchControl* control = nullptr;  // Optional, for stopping or pondering from another thread
+    const IterationCallback* onIteration = nullptr; // Optional, told about every completed iteration
+};
+
+/** Error added to a leaf evaluation at weak levels: fixed per position within a search, so transpositions
+    agree, and triangular on [-noiseCp, noiseCp] so small misjudgements are the most common **/
+static int evaluation_noise(const SearchContext& ctx, uint64_t hash) {
+    uint64_t x = (hash ^ ctx.limits.noiseSeed) * 0x9E3779B97F4A7C15ULL;
+    x ^= x >> 29;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 32;
+    uint64_t range = (uint64_t)ctx.limits.noiseCp + 1;
+    return (int)((x & 0xFFFFFFFF) % range) - (int)((x >> 32) % range);
+}
+
+static bool is_pondering(const SearchContext& ctx) {
+    return ctx.control && ctx.control->pondering.load(std::memory_order_relaxed);
+}
+
+/** Checks the stop signal and the limits (unless pondering); the clock is only read every 1024 nodes **/
+static bool should_stop(SearchContext& ctx) {
+    if (ctx.control && ctx.control->stop.load(std::memory_order_relaxed)) {
+        ctx.stopped = true;
+    } else if (is_pondering(ctx) || ctx.rootMoveNeeded) {
+        return false;
+    } else if (ctx.rootDepth > ctx.limits.depth) {
+        // A ponder hit arrived during an iteration beyond the depth limit
+        ctx.stopped = true;
+    } else if (ctx.limits.nodes && ctx.nodes >= ctx.limits.nodes) {
+        ctx.stopped = true;
+    } else if (ctx.limits.moveTimeMs && (ctx.nodes & 1023) == 0) {
+        auto elapsed = std::chrono::steady_clock::now() - ctx.startTime;
+        if (std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() >= ctx.limits.moveTimeMs) {
+            ctx.stopped = true;
+        }
+    }
+    return ctx.stopped;
+}
+
+/** Remembers a quiet move that caused a cutoff so sibling nodes try it right after the captures **/
+static void store_killer(SearchContext& ctx, int ply, PackedMove move) {
+    PackedMove* killers = ctx.killers[ply];
+    if (killers[0] != move) {
+        killers[1] = killers[0];
+        killers[0] = move;
+    }
+}
+
+/** The line at this ply becomes the move followed by the line just found below it **/
+static void update_pv(SearchContext& ctx, int ply, PackedMove move) {
+    ctx.pv[ply][0] = move;
+    std::copy(ctx.pv[ply + 1], ctx.pv[ply + 1] + ctx.pvLength[ply + 1], ctx.pv[ply] + 1);
+    ctx.pvLength[ply] = ctx.pvLength[ply + 1] + 1;
+}
+
+/** Quiescence search: resolves captures at the horizon so the evaluation is not taken mid-exchange.
+    Captures that lose material by static exchange are pruned; in check every evasion is searched. **/
+template<Color Us>
+static int quiescence(ChessBoard& board, SearchContext& ctx, int ply, int alpha, int beta) {
+    ctx.nodes++;
+    if (should_stop(ctx)) return 0;
+
+    int standPat = (Us == WHITE) ? evaluate_board(board) : -evaluate_board(board);
+    if (ctx.limits.noiseCp) standPat += evaluation_noise(ctx, board.hash);
+    TRACE(TRACE_QUIESCE, ply, 0, 0, NO_MOVE, standPat, alpha, beta, board.hash);
+    if (ply >= MAX_QUIESCENCE_PLY) return standPat;
+
+    bool inCheck = in_check<Us>(board);
+    int bestEval = inCheck ? ALPHA_INITIAL : standPat;
+    if (!inCheck) {
+        // Standing pat: the side to move is not forced to capture
+        if (standPat >= beta) return standPat;
+        alpha = std::max(alpha, standPat);
+    }
+
+    const PackedMove noKillers[2] = { NO_MOVE, NO_MOVE };
+    MovePicker<Us> picker = inCheck ? MovePicker<Us>(board, NO_MOVE, noKillers) : MovePicker<Us>(board);
+    bool anyMove = false;
+    for (PackedMove move = picker.next(); move != NO_MOVE; move = picker.next()) {
+        anyMove = true;
+        make_move(board, move);
+        int eval = -quiescence<opposite(Us)>(board, ctx, ply + 1, -beta, -alpha);
+        board.unmake_move();
+        if (ctx.stopped) return 0;
+
+        bestEval = std::max(bestEval, eval);
+        alpha = std::max(alpha, eval);
+        if (beta <= alpha) break;
+    }
+    return (inCheck && !anyMove) ? ply - MATE_SCORE : bestEval;
+}
+
+/** Quiescence search outside of a tree search, for evaluating leaves of other search methods **/
+int quiescence_score(ChessBoard& board) {
+    SearchContext ctx;
+    return (board.sideToMove == WHITE) ? quiescence<WHITE>(board, ctx, 0, ALPHA_INITIAL, BETA_INITIAL)
+                                       : quiescence<BLACK>(board, ctx, 0, ALPHA_INITIAL, BETA_INITIAL);
+}
+
+/** Mate scores are stored relative to the node rather than the root, so they stay valid at any ply **/
+static int score_to_tt(int score, int ply) {
+    return (score >= MATE_BOUND) ? score + ply : (score <= -MATE_BOUND) ? score - ply : score;
+}
+
+static int score_from_tt(int score, int ply) {
+    return (score >= MATE_BOUND) ? score - ply : (score <= -MATE_BOUND) ? score + ply : score;
+}
+
+/** Negamax with Alpha-Beta Pruning, specialized for the side to move **/
+template<Color Us>
+static int negamax(ChessBoard& board, SearchContext& ctx, int depth, int ply, int alpha, int beta) {
+    ctx.pvLength[ply] = 0; // Lines end at the horizon and at table cutoffs
+    ctx.nodes++;
+    if (should_stop(ctx)) return 0;
+    TRACE(TRACE_ENTER, ply, depth, 0, NO_MOVE, 0, alpha, beta, board.hash);
+
+    // Repeated positions and fifty-move positions are draws; nothing is gained by searching them
+    if (board.repetition_count() > 0 || board.is_fifty_move_draw()) return 0;
+    if (depth == 0) return quiescence<Us>(board, ctx, ply, alpha, beta);
+
+    // A deep enough stored result ends the search here; otherwise its move is tried first
+    TTEntry entry;
+    PackedMove ttMove = NO_MOVE;
+    if (ctx.tt && ctx.tt->probe(board.hash, entry)) {
+        int ttScore = score_from_tt(entry.score, ply);
+        if (entry.depth >= depth && (entry.bound == BOUND_EXACT ||
+                                     (entry.bound == BOUND_LOWER && ttScore >= beta) ||
+                                     (entry.bound == BOUND_UPPER && ttScore <= alpha))) {
+            TRACE(TRACE_TT_HIT, ply, entry.depth, entry.bound, entry.move, ttScore, alpha, beta, board.hash);
+            return ttScore;
+        }
+        ttMove = entry.move;
+    }
+
+    // Moves are generated stage by stage, so a cutoff skips generating the rest
+    MovePicker<Us> picker(board, ttMove, ctx.killers[ply]);
+    int originalAlpha = alpha;
+    int bestEval = ALPHA_INITIAL;
+    PackedMove bestMove = NO_MOVE;
+    int moveIndex = 0;
+    for (PackedMove move = picker.next(); move != NO_MOVE; move = picker.next(), moveIndex++) {
+        TRACE(TRACE_MOVE, ply, depth, moveIndex, move, 0, alpha, beta, board.hash);
+        make_move(board, move);
+        int eval = -negamax<opposite(Us)>(board, ctx, depth - 1, ply + 1, -beta, -alpha);
+        board.unmake_move();
+        if (ctx.stopped) return 0;
+
+        if (eval > bestEval || bestMove == NO_MOVE) {
+            bestEval = eval;
+            bestMove = move;
+        }
+        if (eval > alpha && eval < beta) update_pv(ctx, ply, move);
+        alpha = std::max(alpha, eval);
+        if (beta <= alpha) {
+            TRACE(TRACE_CUTOFF, ply, depth, moveIndex, move, eval, alpha, beta, board.hash);
+            if (!is_tactical(board, move)) store_killer(ctx, ply, move);
+            break;
+        }
+    }
+
+    if (bestMove == NO_MOVE) {
+        // If no moves are available, it's either checkmate (sooner is worse) or stalemate
+        int score = in_check<Us>(board) ? ply - MATE_SCORE : 0;
+        TRACE(TRACE_EXIT, ply, depth, BOUND_EXACT, NO_MOVE, score, alpha, beta, board.hash);
+        return score;
+    }
+
+    Bound bound = (bestEval <= originalAlpha) ? BOUND_UPPER : (bestEval >= beta) ? BOUND_LOWER : BOUND_EXACT;
+    TRACE(TRACE_EXIT, ply, depth, bound, bestMove, bestEval, originalAlpha, beta, board.hash);
+    if (ctx.tt) {
+        ctx.tt->store(board.hash, depth, score_to_tt(bestEval, ply), bound, bestMove);
+    }
+    return bestEval;
+}
+
+/** Minimax with Alpha-Beta Pruning Algorithm, scored from White's point of view **/
 int minimax(ChessBoard& board, int depth, bool isMaximizingPlayer, int alpha, int beta, int& moveCount) {
-    if (depth == 0 || moveCount > MAX_MOVES) return evaluate_board(board);
-
-    std::vector<std::pair<int, int>> allMoves;
-    for (int row = 0; row < NUM_TILES; row++) {
-        for (int col = 0; col < NUM_TILES; col++) {
-            if (board.board[row][col].color == (isMaximizingPlayer ? WHITE : BLACK)) {
-                auto moves = generate_moves(board, row, col);
-                for (const auto& move : moves) {
-                    allMoves.push_back({row * NUM_TILES + col, move.first * NUM_TILES + move.second});
-                }
+    SearchContext ctx;
+    int eval = isMaximizingPlayer ? negamax<WHITE>(board, ctx, depth, 0, alpha, beta)
+                                  : -negamax<BLACK>(board, ctx, depth, 0, -beta, -alpha);
+    moveCount += (int)ctx.nodes;
+    return eval;
+}
+
+/** The k-th highest of the first count scores **/
+static int kth_best_score(const int* scores, int count, int k) {
+    int sorted[256];
+    std::copy(scores, scores + count, sorted);
+    std::nth_element(sorted, sorted + k - 1, sorted + count, std::greater<int>());
+    return sorted[k - 1];
+}
+
+/** Continues a line that stopped at a table cutoff with the table's moves, for as long as they are legal **/
+static void extend_from_table(const ChessBoard& root, TranspositionTable* tt, std::vector<PackedMove>& line, int maxLength) {
+    if (!tt) return;
+    ChessBoard board = root;
+    for (PackedMove move : line) {
+        make_move(board, move);
+    }
+    TTEntry entry;
+    while ((int)line.size() < maxLength && board.repetition_count() == 0 && tt->probe(board.hash, entry)) {
+        MoveList moves;
+        generate_legal_moves(board, moves);
+        if (std::find(moves.begin(), moves.end(), entry.move) == moves.end()) break;
+        make_move(board, entry.move);
+        line.push_back(entry.move);
+    }
+}
+
+/** Iterative deepening for color Us, searching the previous iteration's best moves first. With several
+    lines wanted, a root move only has to beat the weakest line so far to get an exact score. **/
+template<Color Us>
+static SearchResult search_root(ChessBoard& board, SearchContext& ctx) {
+    SearchResult result;
+    MoveList moves;
+    generate_legal_moves<Us>(board, moves);
+    if (moves.empty()) return result;
+
+    TTEntry entry;
+    if (ctx.tt && ctx.tt->probe(board.hash, entry)) {
+        for (int i = 1; i < moves.size; i++) {
+            if (moves.moves[i] == entry.move) std::swap(moves.moves[0], moves.moves[i]);
+        }
+    }
+
+    // While pondering there is no depth limit until the ponder hit arrives
+    int multiPv = std::min(std::max(ctx.limits.multiPv, 1), moves.size);
+    int scores[256];
+    std::vector<std::vector<PackedMove>> lines(ctx.onIteration ? moves.size : 0); // Each root move's line
+    ctx.rootMoveNeeded = true;
+    for (int depth = 1; depth <= MAX_SEARCH_DEPTH && (depth <= ctx.limits.depth || is_pondering(ctx)); depth++) {
+        ctx.rootDepth = depth;
+        TRACE(TRACE_ITERATION, 0, depth, 0, NO_MOVE, 0, 0, 0, board.hash);
+        int alpha = ALPHA_INITIAL;
+        int bestIndex = -1;
+        for (int i = 0; i < moves.size; i++) {
+            int bound = (i < multiPv) ? ALPHA_INITIAL : kth_best_score(scores, i, multiPv);
+            TRACE(TRACE_MOVE, 0, depth, i, moves.moves[i], 0, bound, BETA_INITIAL, board.hash);
+            make_move(board, moves.moves[i]);
+            int eval = -negamax<opposite(Us)>(board, ctx, depth - 1, 1, -BETA_INITIAL, -bound);
+            board.unmake_move();
+            ctx.rootMoveNeeded = false;
+            if (ctx.stopped) break;
+            scores[i] = eval;
+            if (ctx.onIteration && eval > bound) {
+                lines[i].assign(1, moves.moves[i]);
+                lines[i].insert(lines[i].end(), ctx.pv[1], ctx.pv[1] + ctx.pvLength[1]);
+            }
+            if (eval > alpha || bestIndex < 0) {
+                alpha = eval;
+                bestIndex = i;
             }
         }
+
+        // An interrupted iteration is only trusted if nothing better is available
+        if (bestIndex >= 0 && (!ctx.stopped || result.bestMove == NO_MOVE)) {
+            result.bestMove = moves.moves[bestIndex];
+            result.score = alpha;
+            result.depth = ctx.stopped ? depth - 1 : depth;
+            std::swap(moves.moves[0], moves.moves[bestIndex]);
+            std::swap(scores[0], scores[bestIndex]);
+            if (ctx.onIteration) std::swap(lines[0], lines[bestIndex]);
+            if (ctx.tt && !ctx.stopped) ctx.tt->store(board.hash, depth, alpha, BOUND_EXACT, result.bestMove);
+            TRACE(TRACE_EXIT, 0, depth, BOUND_EXACT, result.bestMove, alpha, ALPHA_INITIAL, BETA_INITIAL, board.hash);
+        }
+        if (ctx.stopped) break;
+
+        // The other lines follow the best in order; moves that failed low keep their places
+        for (int k = 1; k < multiPv; k++) {
+            int next = (int)(std::max_element(scores + k, scores + moves.size) - scores);
+            std::swap(moves.moves[k], moves.moves[next]);
+            std::swap(scores[k], scores[next]);
+            if (ctx.onIteration) std::swap(lines[k], lines[next]);
+        }
+        if (ctx.onIteration) {
+            AnalysisInfo info;
+            info.depth = depth;
+            info.nodes = ctx.nodes;
+            for (int k = 0; k < multiPv; k++) {
+                AnalysisLine line;
+                line.score = scores[k];
+                line.pv = lines[k];
+                extend_from_table(board, ctx.tt, line.pv, depth);
+                info.lines.push_back(line);
+            }
+            (*ctx.onIteration)(info);
+        }
+        // A mate found within the full-width depth is the shortest; deeper iterations cannot improve it
+        if (is_mate_score(alpha) && MATE_SCORE - std::abs(alpha) <= depth) break;
     }
+    result.nodes = ctx.nodes;
+    return result;
+}
 
-    if (allMoves.empty()) {
-        // If no moves are available, it's either checkmate or stalemate
-        if (is_check(board, isMaximizingPlayer ? WHITE : BLACK)) {
-            return isMaximizingPlayer ? ALPHA_INITIAL : BETA_INITIAL;
-        } else {
-            return 0; // Stalemate
+/** Searches the position for the side to move within the given limits **/
+SearchResult search_best_move(ChessBoard& board, const SearchLimits& limits, TranspositionTable* tt, SearchControl* control,
+                              const IterationCallback& onIteration) {
+    SearchContext ctx;
+    ctx.limits = limits;
+    ctx.startTime = std::chrono::steady_clock::now();
+    ctx.tt = limits.noiseCp ? nullptr : tt; // Noisy scores must not reach a table that is kept, saved or shared
+    ctx.control = control;
+    ctx.onIteration = onIteration ? &onIteration : nullptr;
+    EvalStats before = eval_stats();
+    TRACE(TRACE_SEARCH, 0, limits.depth, 0, NO_MOVE, 0, 0, 0, board.hash);
+    SearchResult result = (board.sideToMove == WHITE) ? search_root<WHITE>(board, ctx) : search_root<BLACK>(board, ctx);
+    result.evalStats = eval_stats() - before;
+    trace_flush_thread(); // Each search's events reach the file in one piece once it is done
+
+    // Alpha-beta only knows the mate's length; the proof-number solver supplies the line. Its mate
+    // is only adopted when it is no longer, so the reported line always starts with the best move.
+    // Searches on a smaller node budget than the solver's are left as they are.
+    if (result.score >= MATE_BOUND && !(control && control->stop.load()) &&
+        (!limits.nodes || limits.nodes >= MATE_SOLVER_NODES)) {
+        MateSolverOptions options;
+        options.nodes = MATE_SOLVER_NODES;
+        options.hashMb = MATE_SOLVER_MB;
+        MateResult mate = solve_mate(board, options, control);
+        if (mate.status == MATE_PROVEN && !mate.line.empty() && mate.mateIn <= mate_in_moves(result.score)) {
+            result.bestMove = mate.line.front();
+            result.mateLine = mate.line;
         }
     }
+    return result;
+}
 
-    if (isMaximizingPlayer) {
-        int maxEval = ALPHA_INITIAL;
-        for (const auto& move : allMoves) {
-            int srcRow = move.first / NUM_TILES, srcCol = move.first % NUM_TILES;
-            int destRow = move.second / NUM_TILES, destCol = move.second % NUM_TILES;
+// The GUI's table outlives single moves so pondering, analysis and later searches can reuse it.
+// The ponderer and analyzer are declared after it so they are destroyed (and their threads joined) first.
+static TranspositionTable gameTable;
+static Ponderer ponderer(gameTable);
+static Analyzer analyzer(gameTable);
+static bool ponderEnabled = true;
+static bool analysisOn = false;
+static int analysisLines = 3;
+static int strengthLevel = DEFAULT_STRENGTH_LEVEL;
+static Engine selectedEngine = ENGINE_ALPHA_BETA;
+static MctsTree gameTree;           // Keeps the subtree of the moves played between MCTS searches
+static MctsOptions mctsOptions;
 
-            ChessBoard tempBoard = board;
-            tempBoard.board[destRow][destCol] = tempBoard.board[srcRow][srcCol];
-            tempBoard.board[srcRow][srcCol] = { EMPTY, NONE };
+void set_engine(Engine engine, int threads) {
+    selectedEngine = engine;
+    mctsOptions.threads = std::max(threads, 1);
+    if (engine != ENGINE_ALPHA_BETA) ponderer.stop();
+}
 
-            moveCount++;
-            int eval = minimax(tempBoard, depth - 1, false, alpha, beta, moveCount);
-            maxEval = std::max(maxEval, eval);
-            alpha = std::max(alpha, eval);
-            if (beta <= alpha) break;
-        }
-        return maxEval;
+bool set_hash(size_t megabytes, const std::string& sharedName) {
+    ponderer.stop();
+    analyzer.stop();
+    if (!sharedName.empty()) return gameTable.open_shared(sharedName, megabytes);
+    gameTable.resize(megabytes);
+    return true;
+}
+
+// Saved scores are only valid for the evaluation that produced them: the network, or without one the
+// weights tools/tune generated
+static uint64_t evaluation_tag() {
+    return nnue_enabled() ? nnue_network_checksum() : eval_params_hash();
+}
+
+bool load_hash_file(const std::string& path) {
+    return gameTable.load(path, evaluation_tag());
+}
+
+bool save_hash_file(const std::string& path) {
+    return gameTable.save(path, evaluation_tag());
+}
+
+void set_pondering(bool enabled) {
+    ponderEnabled = enabled;
+    if (!enabled) ponderer.stop();
+}
+
+void stop_pondering() {
+    ponderer.stop();
+}
+
+void set_analysis(bool enabled, int lines) {
+    analysisOn = enabled;
+    analysisLines = std::max(lines, 1);
+    if (enabled) {
+        ponderer.stop(); // Analysis takes the player's time instead
     } else {
-        int minEval = BETA_INITIAL;
-        for (const auto& move : allMoves) {
-            int srcRow = move.first / NUM_TILES, srcCol = move.first % NUM_TILES;
-            int destRow = move.second / NUM_TILES, destCol = move.second % NUM_TILES;
-
-            ChessBoard tempBoard = board;
-            tempBoard.board[destRow][destCol] = tempBoard.board[srcRow][srcCol];
-            tempBoard.board[srcRow][srcCol] = { EMPTY, NONE };
-
-            moveCount++;
-            int eval = minimax(tempBoard, depth - 1, true, alpha, beta, moveCount);
-            minEval = std::min(minEval, eval);
-            beta = std::min(beta, eval);
-            if (beta <= alpha) break;
-        }
-        return minEval;
+        analyzer.stop();
     }
 }
 
+bool analysis_enabled() {
+    return analysisOn;
+}
+
+void update_analysis(const ChessBoard& board) {
+    if (analysisOn) analyzer.start(board, analysisLines);
+}
+
+AnalysisInfo analysis_info() {
+    return analysisOn ? analyzer.latest() : AnalysisInfo();
+}
+
+void set_strength(int level) {
+    ponderer.stop(); // A running ponder search has the old level's limits
+    strengthLevel = std::min(std::max(level, MIN_STRENGTH_LEVEL), MAX_STRENGTH_LEVEL);
+}
+
+int get_strength() {
+    return strengthLevel;
+}
+
 /** Function to Make the Best Move **/
 void make_best_move(ChessBoard& board) {
     std::cout << "AI is selecting a move" << std::endl;
-    int bestEval = ALPHA_INITIAL;
-    std::pair<int, int> bestMoveFrom = {-1, -1};
-    std::pair<int, int> bestMoveTo = {-1, -1};
-    int moveCount = 0;
-
-    for (int row = 0; row < NUM_TILES; row++) {
-        for (int col = 0; col < NUM_TILES; col++) {
-            if (board.board[row][col].color == WHITE) {
-                std::vector<std::pair<int, int>> moves = generate_moves(board, row, col);
-                for (const auto& move : moves) {
-                    ChessBoard tempBoard = board;
-                    tempBoard.board[move.first][move.second] = tempBoard.board[row][col];
-                    tempBoard.board[row][col] = { EMPTY, NONE };
-                    int eval = minimax(tempBoard, SEARCH_DEPTH, false, ALPHA_INITIAL, BETA_INITIAL, moveCount);
-                    if (eval > bestEval) {
-                        bestEval = eval;
-                        bestMoveFrom = {row, col};
-                        bestMoveTo = move;
-                    }
-                }
-            }
-        }
+    analyzer.stop(); // The AI's own search gets the CPU; update_analysis resumes on the new position
+    PackedMove expected = ponderer.expected_move();
+    SearchLimits limits = strength_limits(strengthLevel);
+    limits.noiseSeed = (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+    SearchResult result;
+    if (selectedEngine == ENGINE_MCTS) {
+        result = mcts_search(board, limits, gameTree, mctsOptions);
+    } else if (ponderer.finish(board, result)) {
+        std::cout << "Ponder hit on " << move_to_uci(expected) << " (depth " << result.depth << ")" << std::endl;
+    } else {
+        result = search_best_move(board, limits, &gameTable);
+    }
+    PackedMove bestMove = result.bestMove;
+    std::cout << "Searched " << result.nodes << " nodes to depth " << result.depth << "; eval cache hits "
+              << (int)(100 * result.evalStats.eval_hit_rate()) << "%, pawn cache hits "
+              << (int)(100 * result.evalStats.pawn_hit_rate()) << "%" << std::endl;
+    if (!result.mateLine.empty()) {
+        std::cout << "Mate in " << mate_in_moves(result.score) << ": " << line_to_san(board, result.mateLine) << std::endl;
+    } else if (is_mate_score(result.score) && result.score < 0) {
+        std::cout << "Mated in " << -mate_in_moves(result.score) << std::endl;
     }
 
-    if (bestMoveFrom.first != -1 && bestMoveTo.first != -1) {
-        std::cout << "AI selected move from (" << bestMoveFrom.first << "," << bestMoveFrom.second
-                  << ") to (" << bestMoveTo.first << "," << bestMoveTo.second << ")" << std::endl;
-
-        // Record the move before making it
-        board.record_move(bestMoveFrom.first, bestMoveFrom.second, bestMoveTo.first, bestMoveTo.second);
+    if (bestMove != NO_MOVE) {
+        std::cout << "AI selected move from (" << move_src(bestMove) / NUM_TILES << "," << move_src(bestMove) % NUM_TILES
+                  << ") to (" << move_dest(bestMove) / NUM_TILES << "," << move_dest(bestMove) % NUM_TILES << ")" << std::endl;
 
-        // Make the move
-        board.board[bestMoveTo.first][bestMoveTo.second] = board.board[bestMoveFrom.first][bestMoveFrom.second];
-        board.board[bestMoveFrom.first][bestMoveFrom.second] = { EMPTY, NONE };
+        // Make the move, then think about the expected reply on the player's time; weak levels do not,
+        // so an easy game stays cheap
+        make_move(board, bestMove);
+        bool ponder = ponderEnabled && !analysisOn && strengthLevel >= DEFAULT_STRENGTH_LEVEL;
+        if (ponder && selectedEngine == ENGINE_ALPHA_BETA && ponderer.start(board, limits)) {
+            std::cout << "AI is pondering " << move_to_uci(ponderer.expected_move()) << std::endl;
+        }
     } else {
         std::cout << "AI couldn't find a valid move!" << std::endl;
     }
@@ -0,0 +1,40 @@
+#include "analysis.h"
+
+void Analyzer::start(const ChessBoard& board, int lines) {
+    // The history is part of the position: it decides which moves repeat
+    if (active() && board.hash == analysisHash && board.moveHistory.size() == analysisPly && lines == limits.multiPv) {
+        return;
+    }
+    stop();
+
+    analysisBoard = board;
+    analysisHash = board.hash;
+    analysisPly = board.moveHistory.size();
+    limits = SearchLimits();
+    limits.depth = MAX_SEARCH_DEPTH;
+    limits.multiPv = lines;
+    {
+        std::lock_guard<std::mutex> lock(infoMutex);
+        info = AnalysisInfo();
+    }
+    control.stop = false;
+    thread = std::thread([this] {
+        // Results of earlier positions stay in the table, so stepping back through the game is instant
+        search_best_move(analysisBoard, limits, &tt, &control, [this](const AnalysisInfo& iteration) {
+            std::lock_guard<std::mutex> lock(infoMutex);
+            info = iteration;
+        });
+    });
+}
+
+void Analyzer::stop() {
+    if (active()) {
+        control.stop = true;
+        thread.join();
+    }
+}
+
+AnalysisInfo Analyzer::latest() const {
+    std::lock_guard<std::mutex> lock(infoMutex);
+    return info;
+}
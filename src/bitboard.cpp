@@ -0,0 +1,180 @@
+#include "bitboard.h"
+#include <cstddef>
+#include <vector>
+
+// Table sizes: the sum over all squares of 2^(relevant occupancy bits)
+const int BISHOP_TABLE_SIZE = 5248;
+const int ROOK_TABLE_SIZE = 102400;
+
+// Magics found by build_slider's search from its fixed seed. They are tried first, so startup only
+// searches again if a table layout change ever makes one of them collide.
+static const Bitboard BISHOP_MAGICS[64] = {
+    0x0020428400408200ULL, 0x2008010104210004ULL, 0x02D0009200480190ULL, 0x0018158B00010100ULL,
+    0x02C4042132048008ULL, 0x020082202000C221ULL, 0x4000421050080009ULL, 0x0210140202022020ULL,
+    0x00C0101410042248ULL, 0x0405204800D48080ULL, 0x3800C89200420002ULL, 0x180844124A020440ULL,
+    0x04403410A8002221ULL, 0x4040209004200400ULL, 0x084004020202A204ULL, 0x3010002104022000ULL,
+    0x00200240A9110900ULL, 0x2302800404080210ULL, 0x0204188800240010ULL, 0x8048000C01401200ULL,
+    0x120C001A11040900ULL, 0x0000401200500440ULL, 0x00004040840420A0ULL, 0x0020930822880804ULL,
+    0x4044401090900161ULL, 0x0034100015210804ULL, 0x8004100009010120ULL, 0x48C8080000820500ULL,
+    0x0080848004002000ULL, 0x0801004012005044ULL, 0x000080902C040400ULL, 0x0004009005004100ULL,
+    0x0B103010048A0200ULL, 0x8004100203181A00ULL, 0x0800140200100080ULL, 0x8401010800910040ULL,
+    0x0840010011290040ULL, 0x40100214202E1000ULL, 0x0842040040010840ULL, 0x0028010040010860ULL,
+    0x00080202A2051000ULL, 0x4200841008084204ULL, 0x0021120110000D02ULL, 0x48C1004208000084ULL,
+    0x0010088100414400ULL, 0x0021101000420580ULL, 0x0010040558401410ULL, 0x200C0C82A1050205ULL,
+    0x0011108820088000ULL, 0x0001011910120402ULL, 0x1580008608091248ULL, 0x8010018020880C02ULL,
+    0x20A1101032088480ULL, 0x0080100408082800ULL, 0x28100401140401C0ULL, 0x8002102200930012ULL,
+    0x4001040082080200ULL, 0x082200A498081808ULL, 0x000508610080D003ULL, 0x0052020044842402ULL,
+    0x4800A00140C84840ULL, 0x5000000848080820ULL, 0x0101086004240040ULL, 0x0028280808005014ULL
+};
+
+static const Bitboard ROOK_MAGICS[64] = {
+    0x008000908064C000ULL, 0x0040200040001000ULL, 0x0180100080A0010AULL, 0x8880041000800800ULL,
+    0x1200100201200804ULL, 0x0200020004011008ULL, 0x2180010000800600ULL, 0x0200005088210204ULL,
+    0x0400800040008021ULL, 0x0400400020005000ULL, 0x8240801000200080ULL, 0x8611001004200900ULL,
+    0x008180800C001800ULL, 0x0100800200800400ULL, 0x0A02000102000408ULL, 0x8020802300104280ULL,
+    0x0080004000402000ULL, 0xE010104000402000ULL, 0x0800808010002000ULL, 0xA280210008100100ULL,
+    0x0001818014000800ULL, 0xA002010100080400ULL, 0x0080240001020870ULL, 0x0001020004048845ULL,
+    0x0081826280004004ULL, 0x2020810900284000ULL, 0x0200100080802000ULL, 0x0200080080100080ULL,
+    0x8083080100100500ULL, 0x4406000901000400ULL, 0x0005020080800100ULL, 0x0090204200008114ULL,
+    0x0010400094800420ULL, 0x0900804000802002ULL, 0x0201001841002000ULL, 0x4100080080801000ULL,
+    0x4540040080800800ULL, 0x0002001004040020ULL, 0x0281195814001002ULL, 0x1240800040800100ULL,
+    0x0880042000524004ULL, 0x02C080410206002CULL, 0x0801200241050010ULL, 0x8400080010008080ULL,
+    0x0008000500090010ULL, 0x0082009084020008ULL, 0x4012000108020004ULL, 0x9000104D08860004ULL,
+    0x2004204114800100ULL, 0x0148802112400300ULL, 0x0202842000100880ULL, 0x001B080080900080ULL,
+    0x001A002008100600ULL, 0x0004008004020080ULL, 0x5181000600040300ULL, 0x0000044401128A00ULL,
+    0x8044110480002441ULL, 0x2008110084402202ULL, 0x90806005090010C1ULL, 0x000420310A004A42ULL,
+    0x0023001004020801ULL, 0x0882001008040102ULL, 0x000230088118020CULL, 0x0000019025040042ULL
+};
+
+static Bitboard bishopMagicAttacks[BISHOP_TABLE_SIZE];
+static Bitboard bishopPextAttacks[BISHOP_TABLE_SIZE];
+static Bitboard rookMagicAttacks[ROOK_TABLE_SIZE];
+static Bitboard rookPextAttacks[ROOK_TABLE_SIZE];
+
+/** Software bit extract, for building the PEXT tables on any CPU **/
+static Bitboard pext_portable(Bitboard bits, Bitboard mask) {
+    Bitboard result = 0;
+    for (Bitboard bit = 1; mask; bit <<= 1) {
+        if (bits & mask & -mask) result |= bit;
+        mask &= mask - 1;
+    }
+    return result;
+}
+
+/** xorshift64*, for the fallback magic search **/
+static Bitboard next_random(uint64_t& state) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 2685821657736338717ULL;
+}
+
+/** The rays from a square without their last square, whose occupancy never changes the attacks **/
+static Bitboard relevant_mask(int square, const Direction* directions) {
+    Bitboard mask = 0;
+    for (int i = 0; i < 4; i++) {
+        Bitboard ray = ATTACKS.rays[directions[i]][square];
+        if (ray) mask |= ray & ~square_bb(directions[i] < WEST ? msb(ray) : lsb(ray));
+    }
+    return mask;
+}
+
+/** Fills the magic and PEXT tables of one slider. A magic is verified by checking that no two occupancies
+    with different attacks share an index; if the known magic fails, sparse random candidates are tried. **/
+static void build_slider(SliderSquare* squares, Bitboard* magicTable, Bitboard* pextTable, const Direction* directions,
+                         Bitboard (*reference)(int, Bitboard), const Bitboard* knownMagics, uint64_t& seed) {
+    std::vector<Bitboard> occupancies, attacks, used;
+    std::vector<int> epoch;
+    int offset = 0, attempt = 0;
+    for (int square = 0; square < 64; square++) {
+        SliderSquare& entry = squares[square];
+        entry.mask = relevant_mask(square, directions);
+        int bits = popcount(entry.mask);
+        entry.shift = 64 - bits;
+        entry.magicAttacks = magicTable + offset;
+        entry.pextAttacks = pextTable + offset;
+
+        // Every subset of the mask (carry-rippler enumeration) with its attack set
+        occupancies.clear();
+        attacks.clear();
+        Bitboard subset = 0;
+        do {
+            occupancies.push_back(subset);
+            attacks.push_back(reference(square, subset));
+            pextTable[offset + pext_portable(subset, entry.mask)] = attacks.back();
+            subset = (subset - entry.mask) & entry.mask;
+        } while (subset);
+
+        size_t size = occupancies.size();
+        used.assign(size, 0);
+        epoch.assign(size, 0);
+        bool triedKnown = false;
+        for (bool found = false; !found;) {
+            if (!triedKnown) {
+                entry.magic = knownMagics[square];
+                triedKnown = true;
+            } else {
+                do {
+                    entry.magic = next_random(seed) & next_random(seed) & next_random(seed);
+                } while (popcount((entry.mask * entry.magic) >> 56) < 6);
+            }
+            attempt++;
+            found = true;
+            for (size_t i = 0; i < size && found; i++) {
+                size_t index = ((occupancies[i] & entry.mask) * entry.magic) >> entry.shift;
+                if (epoch[index] < attempt) {
+                    epoch[index] = attempt;
+                    used[index] = attacks[i];
+                } else if (used[index] != attacks[i]) {
+                    found = false;
+                }
+            }
+        }
+        for (size_t i = 0; i < size; i++) {
+            magicTable[offset + (((occupancies[i] & entry.mask) * entry.magic) >> entry.shift)] = attacks[i];
+        }
+        offset += (int)size;
+    }
+}
+
+bool pext_supported() {
+#if defined(__x86_64__)
+    return __builtin_cpu_supports("bmi2");
+#else
+    return false;
+#endif
+}
+
+/** PEXT is microcoded on AMD before Zen 3 and much slower there than a multiply **/
+static SliderMode select_slider_mode() {
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (pext_supported() && !__builtin_cpu_is("znver1") && !__builtin_cpu_is("znver2")) return SLIDER_PEXT;
+#endif
+    return SLIDER_MAGIC;
+}
+
+static SliderTables make_slider_tables() {
+    const Direction bishopDirections[4] = { SOUTH_WEST, SOUTH_EAST, NORTH_EAST, NORTH_WEST };
+    const Direction rookDirections[4] = { EAST, SOUTH, WEST, NORTH };
+    SliderTables tables;
+    uint64_t seed = 0x2545F4914F6CDD1DULL;
+    build_slider(tables.bishop, bishopMagicAttacks, bishopPextAttacks, bishopDirections, bishop_attacks_classical,
+                 BISHOP_MAGICS, seed);
+    build_slider(tables.rook, rookMagicAttacks, rookPextAttacks, rookDirections, rook_attacks_classical,
+                 ROOK_MAGICS, seed);
+    tables.mode = select_slider_mode();
+    return tables;
+}
+
+SliderTables SLIDERS = make_slider_tables();
+
+bool set_slider_mode(SliderMode mode) {
+    if (mode == SLIDER_PEXT && !pext_supported()) return false;
+    SLIDERS.mode = mode;
+    return true;
+}
+
+const char* slider_mode_name() {
+    return (SLIDERS.mode == SLIDER_PEXT) ? "pext" : "magic";
+}
@@ -1,6 +1,10 @@
 #include "board.h"
+#include "movegen.h"
 #include <cmath>
+#include <algorithm>
+#include <cctype>
 #include <iostream>
+#include <sstream>
 
 const int NUM_TILES = 8;
 
@@ -17,6 +21,13 @@ ChessBoard::ChessBoard() {
     whiteQueensideRookMoved = false;
     blackKingsideRookMoved = false;
     blackQueensideRookMoved = false;
+
+    // Initialize draw detection state
+    sideToMove = WHITE;
+    halfmoveClock = 0;
+    fullmoveNumber = 1;
+    update_bitboards();
+    hash = compute_hash();
 }
 
 /** Piece Setup Method **/
@@ -55,9 +66,10 @@ std::string piece_to_string(PieceType type) {
     }
 }
 
-bool is_valid_pawn_move(const ChessBoard& board, int srcRow, int srcCol, int destRow, int destCol) {
-    int direction = (board.board[srcRow][srcCol].color == WHITE) ? -1 : 1;
-    int startRow = (board.board[srcRow][srcCol].color == WHITE) ? 6 : 1;
+template<Color Us>
+static bool is_valid_pawn_move(const ChessBoard& board, int srcRow, int srcCol, int destRow, int destCol) {
+    constexpr int direction = (Us == WHITE) ? -1 : 1;
+    constexpr int startRow = (Us == WHITE) ? 6 : 1;
 
     // Forward move
     if (srcCol == destCol) {
@@ -73,8 +85,7 @@ bool is_valid_pawn_move(const ChessBoard& board, int srcRow, int srcCol, int des
 
     // Capture move
     if (destRow == srcRow + direction && std::abs(destCol - srcCol) == 1) {
-        if (board.board[destRow][destCol].type != EMPTY &&
-            board.board[destRow][destCol].color != board.board[srcRow][srcCol].color) {
+        if (board.board[destRow][destCol].color == opposite(Us)) {
             return true;
         }
         // En passant
@@ -83,7 +94,7 @@ bool is_valid_pawn_move(const ChessBoard& board, int srcRow, int srcCol, int des
             board.lastMoveStart == std::make_pair(destRow + direction, destCol) &&
             board.lastMoveWasPawnDouble &&
             board.board[destRow - direction][destCol].type == PAWN &&
-            board.board[destRow - direction][destCol].color != board.board[srcRow][srcCol].color) {
+            board.board[destRow - direction][destCol].color == opposite(Us)) {
             return true;
         }
     }
@@ -91,6 +102,12 @@ bool is_valid_pawn_move(const ChessBoard& board, int srcRow, int srcCol, int des
     return false;
 }
 
+bool is_valid_pawn_move(const ChessBoard& board, int srcRow, int srcCol, int destRow, int destCol) {
+    return board.board[srcRow][srcCol].color == WHITE
+        ? is_valid_pawn_move<WHITE>(board, srcRow, srcCol, destRow, destCol)
+        : is_valid_pawn_move<BLACK>(board, srcRow, srcCol, destRow, destCol);
+}
+
 bool is_valid_knight_move(int srcRow, int srcCol, int destRow, int destCol) {
     int rowDiff = std::abs(destRow - srcRow);
     int colDiff = std::abs(destCol - srcCol);
@@ -98,39 +115,21 @@ bool is_valid_knight_move(int srcRow, int srcCol, int destRow, int destCol) {
 }
 
 bool is_valid_bishop_move(const ChessBoard& board, int srcRow, int srcCol, int destRow, int destCol) {
-    if (std::abs(destRow - srcRow) != std::abs(destCol - srcCol)) {
-        return false;
-    }
-    int rowDir = (destRow > srcRow) ? 1 : -1;
-    int colDir = (destCol > srcCol) ? 1 : -1;
-    for (int i = 1; i < std::abs(destRow - srcRow); ++i) {
-        if (board.board[srcRow + i * rowDir][srcCol + i * colDir].type != EMPTY) {
-            return false;
-        }
-    }
-    return true;
+    return bishop_attacks(srcRow * NUM_TILES + srcCol, board.occupied()) & square_bb(destRow * NUM_TILES + destCol);
 }
 
 bool is_valid_rook_move(const ChessBoard& board, int srcRow, int srcCol, int destRow, int destCol) {
-    if (srcRow != destRow && srcCol != destCol) {
-        return false;
-    }
-    int rowDir = (destRow > srcRow) ? 1 : (destRow < srcRow) ? -1 : 0;
-    int colDir = (destCol > srcCol) ? 1 : (destCol < srcCol) ? -1 : 0;
-    for (int i = 1; i < std::max(std::abs(destRow - srcRow), std::abs(destCol - srcCol)); ++i) {
-        if (board.board[srcRow + i * rowDir][srcCol + i * colDir].type != EMPTY) {
-            return false;
-        }
-    }
-    return true;
+    return rook_attacks(srcRow * NUM_TILES + srcCol, board.occupied()) & square_bb(destRow * NUM_TILES + destCol);
 }
 
 bool is_valid_queen_move(const ChessBoard& board, int srcRow, int srcCol, int destRow, int destCol) {
-    return is_valid_bishop_move(board, srcRow, srcCol, destRow, destCol) ||
-           is_valid_rook_move(board, srcRow, srcCol, destRow, destCol);
+    Bitboard occupied = board.occupied();
+    int src = srcRow * NUM_TILES + srcCol;
+    return (bishop_attacks(src, occupied) | rook_attacks(src, occupied)) & square_bb(destRow * NUM_TILES + destCol);
 }
 
-bool is_valid_king_move(const ChessBoard& board, int srcRow, int srcCol, int destRow, int destCol) {
+template<Color Us>
+static bool is_valid_king_move(const ChessBoard& board, int srcRow, int srcCol, int destRow, int destCol) {
     int rowDiff = std::abs(destRow - srcRow);
     int colDiff = std::abs(destCol - srcCol);
 
@@ -141,25 +140,24 @@ bool is_valid_king_move(const ChessBoard& board, int srcRow, int srcCol, int des
 
     // Castling
     if (rowDiff == 0 && colDiff == 2) {
-        Color color = board.board[srcRow][srcCol].color;
-        if (color == WHITE && !board.whiteKingMoved) {
-            if (destCol > srcCol && !board.whiteKingsideRookMoved) {
-                return is_castling_valid(board, srcRow, srcCol, destRow, destCol, color);
-            } else if (destCol < srcCol && !board.whiteQueensideRookMoved) {
-                return is_castling_valid(board, srcRow, srcCol, destRow, destCol, color);
-            }
-        } else if (color == BLACK && !board.blackKingMoved) {
-            if (destCol > srcCol && !board.blackKingsideRookMoved) {
-                return is_castling_valid(board, srcRow, srcCol, destRow, destCol, color);
-            } else if (destCol < srcCol && !board.blackQueensideRookMoved) {
-                return is_castling_valid(board, srcRow, srcCol, destRow, destCol, color);
-            }
+        bool kingMoved = (Us == WHITE) ? board.whiteKingMoved : board.blackKingMoved;
+        bool rookMoved = (destCol > srcCol)
+            ? ((Us == WHITE) ? board.whiteKingsideRookMoved : board.blackKingsideRookMoved)
+            : ((Us == WHITE) ? board.whiteQueensideRookMoved : board.blackQueensideRookMoved);
+        if (!kingMoved && !rookMoved) {
+            return is_castling_valid(board, srcRow, srcCol, destRow, destCol, Us);
         }
     }
 
     return false;
 }
 
+bool is_valid_king_move(const ChessBoard& board, int srcRow, int srcCol, int destRow, int destCol) {
+    return board.board[srcRow][srcCol].color == WHITE
+        ? is_valid_king_move<WHITE>(board, srcRow, srcCol, destRow, destCol)
+        : is_valid_king_move<BLACK>(board, srcRow, srcCol, destRow, destCol);
+}
+
 bool is_valid_move(const ChessBoard& board, int srcRow, int srcCol, int destRow, int destCol, Color currentTurn) {
     // Check if the move is within bounds
     if (srcRow < 0 || srcRow >= NUM_TILES || srcCol < 0 || srcCol >= NUM_TILES ||
@@ -210,14 +208,7 @@ bool is_valid_move(const ChessBoard& board, int srcRow, int srcCol, int destRow,
     }
 
     // Check if the move would leave the king in check
-    ChessBoard tempBoard = board;
-    tempBoard.board[destRow][destCol] = tempBoard.board[srcRow][srcCol];
-    tempBoard.board[srcRow][srcCol] = { EMPTY, NONE };
-    if (is_check(tempBoard, currentTurn)) {
-        return false;
-    }
-
-    return true;
+    return !would_be_in_check(board, srcRow, srcCol, destRow, destCol);
 }
 
 bool is_castling_valid(const ChessBoard& board, int srcRow, int srcCol, int destRow, int destCol, Color color) {
@@ -226,9 +217,13 @@ bool is_castling_valid(const ChessBoard& board, int srcRow, int srcCol, int dest
         return false;
     }
 
-    // Check if the squares between the king and rook are empty
+    // Check if the rook is still there and the squares between the king and rook are empty
     int step = (destCol > srcCol) ? 1 : -1;
-    for (int col = srcCol + step; col != destCol; col += step) {
+    int rookCol = (destCol > srcCol) ? 7 : 0;
+    if (board.board[srcRow][rookCol].type != ROOK || board.board[srcRow][rookCol].color != color) {
+        return false;
+    }
+    for (int col = srcCol + step; col != rookCol; col += step) {
         if (board.board[srcRow][col].type != EMPTY) {
             return false;
         }
@@ -236,7 +231,7 @@ bool is_castling_valid(const ChessBoard& board, int srcRow, int srcCol, int dest
 
     // Check if the king passes through or ends up in a square that's under attack
     for (int col = srcCol; col != destCol + step; col += step) {
-        if (is_square_attacked(board, srcRow, col, (color == WHITE) ? BLACK : WHITE)) {
+        if (is_square_attacked(board, srcRow, col, opposite(color))) {
             return false;
         }
     }
@@ -245,16 +240,9 @@ bool is_castling_valid(const ChessBoard& board, int srcRow, int srcCol, int dest
 }
 
 bool is_square_attacked(const ChessBoard& board, int row, int col, Color attackingColor) {
-    for (int r = 0; r < NUM_TILES; r++) {
-        for (int c = 0; c < NUM_TILES; c++) {
-            if (board.board[r][c].color == attackingColor) {
-                if (is_valid_move(board, r, c, row, col, attackingColor)) {
-                    return true;
-                }
-            }
-        }
-    }
-    return false;
+    int square = row * NUM_TILES + col;
+    return attackingColor == WHITE ? attackers_to<WHITE>(board, square, board.occupied()) != 0
+                                   : attackers_to<BLACK>(board, square, board.occupied()) != 0;
 }
 
 std::vector<std::pair<int, int>> get_valid_moves(const ChessBoard& board, int row, int col, Color currentTurn) {
@@ -271,180 +259,429 @@ std::vector<std::pair<int, int>> get_valid_moves(const ChessBoard& board, int ro
 
 /** Function to determine if check **/
 bool is_check(const ChessBoard& board, Color color) {
-    std::pair<int, int> kingPos;
-    for(int row = 0; row < NUM_TILES; row++) {
-        for(int col = 0; col < NUM_TILES; col++) {
-            if(board.board[row][col].type == KING && board.board[row][col].color == color) {
-                kingPos = { row, col };
-                goto found_king;
-            }
-        }
+    return color == WHITE ? in_check<WHITE>(board) : in_check<BLACK>(board);
+}
+
+bool would_be_in_check(const ChessBoard& board, int srcRow, int srcCol, int destRow, int destCol) {
+    PackedMove move = pack_move(srcRow * NUM_TILES + srcCol, destRow * NUM_TILES + destCol);
+    return board.board[srcRow][srcCol].color == WHITE ? !is_legal<WHITE>(board, move) : !is_legal<BLACK>(board, move);
+}
+
+static bool has_legal_moves(const ChessBoard& board, Color color) {
+    MoveList moves;
+    if (color == WHITE) {
+        generate_legal_moves<WHITE>(board, moves);
+    } else {
+        generate_legal_moves<BLACK>(board, moves);
     }
-    found_king:
+    return !moves.empty();
+}
 
-    for(int row = 0; row < NUM_TILES; row++) {
-        for(int col = 0; col < NUM_TILES; col++) {
-            if(board.board[row][col].color != color && board.board[row][col].type != EMPTY) {
-                if(is_valid_move(board, row, col, kingPos.first, kingPos.second, board.board[row][col].color)) {
-                    return true;
-                }
-            }
+/** Function to determine if Checkmate **/
+bool is_checkmate(ChessBoard& board, Color color) {
+    return is_check(board, color) && !has_legal_moves(board, color);
+}
+
+/** Function to detect Stalemate **/
+bool is_stalemate(ChessBoard& board, Color color) {
+    return !is_check(board, color) && !has_legal_moves(board, color);
+}
+
+/** Function to detect a draw where neither side can possibly mate (bare kings, or one minor piece left) **/
+bool has_insufficient_material(const ChessBoard& board) {
+    for (int color = 0; color < 2; color++) {
+        if (board.pieceBB[color][PAWN] | board.pieceBB[color][ROOK] | board.pieceBB[color][QUEEN]) {
+            return false;
         }
     }
-    return false;
+    Bitboard minors = board.pieceBB[WHITE][KNIGHT] | board.pieceBB[WHITE][BISHOP] |
+                      board.pieceBB[BLACK][KNIGHT] | board.pieceBB[BLACK][BISHOP];
+    return popcount(minors) <= 1;
 }
 
-bool would_be_in_check(const ChessBoard& board, int srcRow, int srcCol, int destRow, int destCol) {
-    ChessBoard tempBoard = board;
-    tempBoard.board[destRow][destCol] = tempBoard.board[srcRow][srcCol];
-    tempBoard.board[srcRow][srcCol] = { EMPTY, NONE };
-    return is_check(tempBoard, tempBoard.board[destRow][destCol].color);
+/** Zobrist keys, generated once from a fixed seed so hashes are reproducible between runs **/
+struct ZobristKeys {
+    uint64_t pieces[2][6][64];
+    uint64_t castling[16];           // By castling rights, not by which pieces have moved
+    uint64_t enPassant[8];
+    uint64_t blackToMove;
+
+    ZobristKeys() {
+        uint64_t seed = 0x9E3779B97F4A7C15ULL;
+        for (int color = 0; color < 2; color++)
+            for (int type = 0; type < 6; type++)
+                for (int square = 0; square < 64; square++)
+                    pieces[color][type][square] = next(seed);
+        for (int rights = 0; rights < 16; rights++) castling[rights] = next(seed);
+        for (int file = 0; file < 8; file++) enPassant[file] = next(seed);
+        blackToMove = next(seed);
+    }
+
+    // SplitMix64 generator
+    static uint64_t next(uint64_t& state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+};
+
+static const ZobristKeys& zobrist() {
+    static const ZobristKeys keys;
+    return keys;
 }
 
-/** Function to determine if Checkmate **/
-bool is_checkmate(ChessBoard& board, Color color) {
-    if(!is_check(board, color)) {
-        return false;
+int ChessBoard::castling_flags() const {
+    return (whiteKingMoved ? 1 : 0) | (blackKingMoved ? 2 : 0) |
+           (whiteKingsideRookMoved ? 4 : 0) | (whiteQueensideRookMoved ? 8 : 0) |
+           (blackKingsideRookMoved ? 16 : 0) | (blackQueensideRookMoved ? 32 : 0);
+}
+
+/** The four castling rights (K, Q, k, q as bits 0-3). Different moved-flag combinations can leave the
+ *  same rights, e.g. a rook that moves after its king has, so positions are hashed by these instead. **/
+int ChessBoard::castling_rights() const {
+    return (!whiteKingMoved && !whiteKingsideRookMoved ? 1 : 0) | (!whiteKingMoved && !whiteQueensideRookMoved ? 2 : 0) |
+           (!blackKingMoved && !blackKingsideRookMoved ? 4 : 0) | (!blackKingMoved && !blackQueensideRookMoved ? 8 : 0);
+}
+
+void ChessBoard::set_castling_flags(int flags) {
+    whiteKingMoved = flags & 1;
+    blackKingMoved = flags & 2;
+    whiteKingsideRookMoved = flags & 4;
+    whiteQueensideRookMoved = flags & 8;
+    blackKingsideRookMoved = flags & 16;
+    blackQueensideRookMoved = flags & 32;
+}
+
+/** File of a possible en passant capture, or -1. Only counted when an enemy pawn stands next to
+ *  the double-pushed pawn, so positions differing in an unusable en passant square still repeat. **/
+int ChessBoard::en_passant_file() const {
+    if (!lastMoveWasPawnDouble) return -1;
+    int row = lastMove.first, col = lastMove.second;
+    Color pusher = board[row][col].color;
+    for (int side = -1; side <= 1; side += 2) {
+        int c = col + side;
+        if (c >= 0 && c < NUM_TILES && board[row][c].type == PAWN && board[row][c].color != pusher) {
+            return col;
+        }
     }
+    return -1;
+}
+
+uint64_t ChessBoard::state_key() const {
+    int file = en_passant_file();
+    return zobrist().castling[castling_rights()] ^ (file >= 0 ? zobrist().enPassant[file] : 0);
+}
 
-    for(int srcRow = 0; srcRow < NUM_TILES; srcRow++) {
-        for(int srcCol = 0; srcCol < NUM_TILES; srcCol++) {
-            if(board.board[srcRow][srcCol].color == color) {
-                for(int destRow = 0; destRow < NUM_TILES; destRow++) {
-                    for(int destCol = 0; destCol < NUM_TILES; destCol++) {
-                        if(is_valid_move(board, srcRow, srcCol, destRow, destCol, color)) {
-                            ChessBoard tempBoard = board;
-                            tempBoard.board[destRow][destCol] = tempBoard.board[srcRow][srcCol];
-                            tempBoard.board[srcRow][srcCol] = { EMPTY, NONE };
-                            if(!is_check(tempBoard, color)) {
-                                return false;
-                            }
-                        }
-                    }
-                }
+uint64_t ChessBoard::compute_hash() const {
+    uint64_t key = state_key();
+    for (int row = 0; row < NUM_TILES; row++) {
+        for (int col = 0; col < NUM_TILES; col++) {
+            const Piece& piece = board[row][col];
+            if (piece.type != EMPTY) {
+                key ^= zobrist().pieces[piece.color][piece.type][row * NUM_TILES + col];
             }
         }
     }
-    return true;
+    if (sideToMove == BLACK) key ^= zobrist().blackToMove;
+    return key;
 }
 
-/** Function to detect Stalemate **/
-bool is_stalemate(ChessBoard& board, Color color) {
-    if(is_check(board, color)) {
-        return false;
+/** Rebuilds the bitboards from the board, for when squares were set directly **/
+void ChessBoard::update_bitboards() {
+    for (int color = 0; color < 2; color++) {
+        colorBB[color] = 0;
+        for (int type = 0; type < 6; type++) pieceBB[color][type] = 0;
     }
-
-    for(int srcRow = 0; srcRow < NUM_TILES; srcRow++) {
-        for(int srcCol = 0; srcCol < NUM_TILES; srcCol++) {
-            if(board.board[srcRow][srcCol].color == color) {
-                for(int destRow = 0; destRow < NUM_TILES; destRow++) {
-                    for(int destCol = 0; destCol < NUM_TILES; destCol++) {
-                        if(is_valid_move(board, srcRow, srcCol, destRow, destCol, color)) {
-                            return false;
-                        }
-                    }
-                }
+    for (int row = 0; row < NUM_TILES; row++) {
+        for (int col = 0; col < NUM_TILES; col++) {
+            const Piece& piece = board[row][col];
+            if (piece.type != EMPTY) {
+                pieceBB[piece.color][piece.type] |= square_bb(row * NUM_TILES + col);
+                colorBB[piece.color] |= square_bb(row * NUM_TILES + col);
             }
         }
     }
-    return true;
+    accumulator.network = 0;
 }
 
-void ChessBoard::record_move(int srcRow, int srcCol, int destRow, int destCol) {
-    Piece capturedPiece = board[destRow][destCol];
-    bool wasEnPassant = (board[srcRow][srcCol].type == PAWN && srcCol != destCol && capturedPiece.type == EMPTY);
-    bool wasCastling = (board[srcRow][srcCol].type == KING && std::abs(destCol - srcCol) == 2);
-    bool wasPawnPromotion = (board[srcRow][srcCol].type == PAWN && (destRow == 0 || destRow == 7));
+void ChessBoard::set_square(int row, int col, Piece piece) {
+    board[row][col] = piece;
+    pieceBB[piece.color][piece.type] |= square_bb(row * NUM_TILES + col);
+    colorBB[piece.color] |= square_bb(row * NUM_TILES + col);
+    if (accumulator.network != 0 && accumulator.network == nnue_network_id()) {
+        nnue_add_piece(accumulator, piece, row * NUM_TILES + col);
+    }
+}
 
-    Move move(srcRow, srcCol, destRow, destCol, capturedPiece, wasEnPassant, wasCastling, wasPawnPromotion);
-    moveHistory.push_back(move);
+void ChessBoard::clear_square(int row, int col) {
+    const Piece& piece = board[row][col];
+    pieceBB[piece.color][piece.type] &= ~square_bb(row * NUM_TILES + col);
+    colorBB[piece.color] &= ~square_bb(row * NUM_TILES + col);
+    if (accumulator.network != 0 && accumulator.network == nnue_network_id()) {
+        nnue_remove_piece(accumulator, piece, row * NUM_TILES + col);
+    }
+    board[row][col] = { EMPTY, NONE };
 }
 
-bool ChessBoard::undo_last_move() {
-    if (moveHistory.empty()) return false;
+void ChessBoard::put_piece(int row, int col, Piece piece) {
+    set_square(row, col, piece);
+    hash ^= zobrist().pieces[piece.color][piece.type][row * NUM_TILES + col];
+}
 
-    Move& move = moveHistory.back();
+void ChessBoard::remove_piece(int row, int col) {
+    const Piece& piece = board[row][col];
+    hash ^= zobrist().pieces[piece.color][piece.type][row * NUM_TILES + col];
+    clear_square(row, col);
+}
+
+/** Plays a move with all special rules, keeping the hash, halfmove clock and histories up to date **/
+void ChessBoard::make_move(int srcRow, int srcCol, int destRow, int destCol, PieceType promotion) {
+    Piece piece = board[srcRow][srcCol];
+    Piece capturedPiece = board[destRow][destCol];
+    bool wasEnPassant = (piece.type == PAWN && srcCol != destCol && capturedPiece.type == EMPTY);
+    bool wasCastling = (piece.type == KING && std::abs(destCol - srcCol) == 2);
+    bool wasPawnPromotion = (piece.type == PAWN && (destRow == 0 || destRow == 7));
+
+    Move move(srcRow, srcCol, destRow, destCol, capturedPiece, wasEnPassant, wasCastling, wasPawnPromotion,
+              wasPawnPromotion ? promotion : EMPTY);
+    move.prevCastlingFlags = castling_flags();
+    move.prevHalfmoveClock = halfmoveClock;
+    move.prevLastMove = lastMove;
+    move.prevLastMoveStart = lastMoveStart;
+    move.prevLastMoveWasPawnDouble = lastMoveWasPawnDouble;
+    moveHistory.push_back(move);
+    positionHistory.push_back(hash);
 
-    // Undo the move
-    board[move.srcRow][move.srcCol] = board[move.destRow][move.destCol];
-    board[move.destRow][move.destCol] = move.capturedPiece;
+    hash ^= state_key();
+
+    // Move the piece, removing whatever it captures
+    if (capturedPiece.type != EMPTY) {
+        remove_piece(destRow, destCol);
+    }
+    if (wasEnPassant) {
+        remove_piece(srcRow, destCol);
+    }
+    remove_piece(srcRow, srcCol);
+    if (wasPawnPromotion) {
+        piece.type = promotion;
+    }
+    put_piece(destRow, destCol, piece);
+
+    // Move the rook when castling
+    if (wasCastling) {
+        int rookSrcCol = (destCol > srcCol) ? 7 : 0;
+        int rookDestCol = (destCol > srcCol) ? destCol - 1 : destCol + 1;
+        Piece rook = board[srcRow][rookSrcCol];
+        remove_piece(srcRow, rookSrcCol);
+        put_piece(srcRow, rookDestCol, rook);
+    }
+
+    // Update castling flags, treating a rook captured on its home square as moved
+    if (srcRow == 0 && srcCol == 4) blackKingMoved = true;
+    if (srcRow == 7 && srcCol == 4) whiteKingMoved = true;
+    if ((srcRow == 0 && srcCol == 0) || (destRow == 0 && destCol == 0)) blackQueensideRookMoved = true;
+    if ((srcRow == 0 && srcCol == 7) || (destRow == 0 && destCol == 7)) blackKingsideRookMoved = true;
+    if ((srcRow == 7 && srcCol == 0) || (destRow == 7 && destCol == 0)) whiteQueensideRookMoved = true;
+    if ((srcRow == 7 && srcCol == 7) || (destRow == 7 && destCol == 7)) whiteKingsideRookMoved = true;
+
+    // Update last move information
+    lastMoveStart = {srcRow, srcCol};
+    lastMove = {destRow, destCol};
+    lastMoveWasPawnDouble = (piece.type == PAWN && std::abs(destRow - srcRow) == 2);
+
+    // Captures and pawn moves are irreversible and reset the fifty-move counter
+    halfmoveClock = (piece.type == PAWN || capturedPiece.type != EMPTY) ? 0 : halfmoveClock + 1;
+
+    if (sideToMove == BLACK) fullmoveNumber++;
+    sideToMove = (sideToMove == WHITE) ? BLACK : WHITE;
+    hash ^= zobrist().blackToMove;
+    hash ^= state_key();
+}
+
+/** Takes back the last move made with make_move **/
+void ChessBoard::unmake_move() {
+    Move move = moveHistory.back();
+    moveHistory.pop_back();
+
+    Piece piece = board[move.destRow][move.destCol];
+    if (move.wasPawnPromotion) {
+        piece.type = PAWN;
+    }
+    clear_square(move.destRow, move.destCol);
+    set_square(move.srcRow, move.srcCol, piece);
+    if (move.capturedPiece.type != EMPTY) {
+        set_square(move.destRow, move.destCol, move.capturedPiece);
+    }
 
     // Handle special cases
     if (move.wasEnPassant) {
-        int capturedPawnRow = (move.srcRow + move.destRow) / 2;
-        board[capturedPawnRow][move.destCol] = {PAWN, (Color)(1 - board[move.srcRow][move.srcCol].color)};
+        set_square(move.srcRow, move.destCol, { PAWN, opposite(piece.color) });
     } else if (move.wasCastling) {
         int rookSrcCol = (move.destCol > move.srcCol) ? 7 : 0;
         int rookDestCol = (move.destCol > move.srcCol) ? move.destCol - 1 : move.destCol + 1;
-        board[move.srcRow][rookSrcCol] = board[move.srcRow][rookDestCol];
-        board[move.srcRow][rookDestCol] = {EMPTY, NONE};
-    } else if (move.wasPawnPromotion) {
-        board[move.srcRow][move.srcCol].type = PAWN;
+        Piece rook = board[move.srcRow][rookDestCol];
+        clear_square(move.srcRow, rookDestCol);
+        set_square(move.srcRow, rookSrcCol, rook);
     }
 
-    // Update castling flags
-    if (move.srcRow == 0 && move.srcCol == 4) blackKingMoved = false;
-    if (move.srcRow == 7 && move.srcCol == 4) whiteKingMoved = false;
-    if (move.srcRow == 0 && move.srcCol == 0) blackQueensideRookMoved = false;
-    if (move.srcRow == 0 && move.srcCol == 7) blackKingsideRookMoved = false;
-    if (move.srcRow == 7 && move.srcCol == 0) whiteQueensideRookMoved = false;
-    if (move.srcRow == 7 && move.srcCol == 7) whiteKingsideRookMoved = false;
+    // Restore the state saved before the move
+    set_castling_flags(move.prevCastlingFlags);
+    halfmoveClock = move.prevHalfmoveClock;
+    lastMove = move.prevLastMove;
+    lastMoveStart = move.prevLastMoveStart;
+    lastMoveWasPawnDouble = move.prevLastMoveWasPawnDouble;
+    sideToMove = piece.color;
+    if (sideToMove == BLACK) fullmoveNumber--;
+    hash = positionHistory.back();
+    positionHistory.pop_back();
+}
 
-    // Update last move information
-    if (moveHistory.size() > 1) {
-        Move& prevMove = moveHistory[moveHistory.size() - 2];
-        lastMoveStart = {prevMove.srcRow, prevMove.srcCol};
-        lastMove = {prevMove.destRow, prevMove.destCol};
-        lastMoveWasPawnDouble = (prevMove.srcRow == 1 && prevMove.destRow == 3) || (prevMove.srcRow == 6 && prevMove.destRow == 4);
-    } else {
-        lastMoveStart = {-1, -1};
-        lastMove = {-1, -1};
-        lastMoveWasPawnDouble = false;
-    }
+bool ChessBoard::undo_last_move() {
+    if (moveHistory.empty()) return false;
 
-    moveHistory.pop_back();
+    redoHistory.push_back(moveHistory.back());
+    unmake_move();
     return true;
 }
 
 bool ChessBoard::redo_move() {
-    if (moveHistory.empty() || moveHistory.size() == moveHistory.capacity()) return false;
-
-    Move& move = moveHistory[moveHistory.size()];
+    if (redoHistory.empty()) return false;
 
-    // Redo the move
-    board[move.destRow][move.destCol] = board[move.srcRow][move.srcCol];
-    board[move.srcRow][move.srcCol] = { EMPTY, NONE };
+    Move move = redoHistory.back();
+    redoHistory.pop_back();
+    make_move(move.srcRow, move.srcCol, move.destRow, move.destCol,
+              move.wasPawnPromotion ? move.promotedTo : QUEEN);
+    return true;
+}
 
-    // Handle special cases
-    if (move.wasEnPassant) {
-        int capturedPawnRow = (move.srcRow + move.destRow) / 2;
-        board[capturedPawnRow][move.destCol] = { EMPTY, NONE };
-    } else if (move.wasCastling) {
-        int rookSrcCol = (move.destCol > move.srcCol) ? 7 : 0;
-        int rookDestCol = (move.destCol > move.srcCol) ? move.destCol - 1 : move.destCol + 1;
-        board[move.srcRow][rookDestCol] = board[move.srcRow][rookSrcCol];
-        board[move.srcRow][rookSrcCol] = { EMPTY, NONE };
-    } else if (move.wasPawnPromotion) {
-        board[move.destRow][move.destCol].type = QUEEN; // Assuming promotion is always to queen
+/** Number of earlier occurrences of the current position with the same side to move. Only positions
+ *  since the last irreversible move are scanned, since nothing before it can repeat. **/
+int ChessBoard::repetition_count() const {
+    int count = 0;
+    int limit = std::min(halfmoveClock, (int)positionHistory.size());
+    for (int i = 4; i <= limit; i += 2) {
+        if (positionHistory[positionHistory.size() - i] == hash) {
+            count++;
+        }
     }
+    return count;
+}
 
-    // Update castling flags
-    if (move.srcRow == 0 && move.srcCol == 4) blackKingMoved = true;
-    if (move.srcRow == 7 && move.srcCol == 4) whiteKingMoved = true;
-    if (move.srcRow == 0 && move.srcCol == 0) blackQueensideRookMoved = true;
-    if (move.srcRow == 0 && move.srcCol == 7) blackKingsideRookMoved = true;
-    if (move.srcRow == 7 && move.srcCol == 0) whiteQueensideRookMoved = true;
-    if (move.srcRow == 7 && move.srcCol == 7) whiteKingsideRookMoved = true;
+bool ChessBoard::is_fifty_move_draw() const {
+    return halfmoveClock >= 100;
+}
 
-    // Update last move information
-    lastMoveStart = {move.srcRow, move.srcCol};
-    lastMove = {move.destRow, move.destCol};
-    lastMoveWasPawnDouble = (board[move.destRow][move.destCol].type == PAWN && std::abs(move.destRow - move.srcRow) == 2);
+/** Sets up a position from FEN. The move counters are optional, so EPD positions load too.
+ *  Returns false and leaves the board unchanged if the FEN is malformed. **/
+bool ChessBoard::load_fen(const std::string& fen) {
+    std::istringstream stream(fen);
+    std::string placement, side, castling, enPassant;
+    if (!(stream >> placement >> side >> castling >> enPassant)) return false;
 
-    moveHistory.push_back(move);
+    ChessBoard result;
+    for (auto& row : result.board) {
+        for (auto& square : row) square = { EMPTY, NONE };
+    }
+
+    // Piece placement, from row 0 (rank 8) down to row 7 (rank 1)
+    int row = 0, col = 0;
+    for (char c : placement) {
+        if (c == '/') {
+            if (col != NUM_TILES || ++row >= NUM_TILES) return false;
+            col = 0;
+        } else if (c >= '1' && c <= '8') {
+            col += c - '0';
+            if (col > NUM_TILES) return false;
+        } else {
+            size_t type = std::string("kqrbnp").find((char)std::tolower(c));
+            if (type == std::string::npos || col >= NUM_TILES) return false;
+            result.board[row][col++] = { (PieceType)type, std::isupper(c) ? WHITE : BLACK };
+        }
+    }
+    if (row != NUM_TILES - 1 || col != NUM_TILES) return false;
+
+    if (side != "w" && side != "b") return false;
+    result.sideToMove = (side == "w") ? WHITE : BLACK;
+
+    if (castling.find_first_not_of("KQkq-") != std::string::npos) return false;
+    result.whiteKingMoved = castling.find_first_of("KQ") == std::string::npos;
+    result.blackKingMoved = castling.find_first_of("kq") == std::string::npos;
+    result.whiteKingsideRookMoved = castling.find('K') == std::string::npos;
+    result.whiteQueensideRookMoved = castling.find('Q') == std::string::npos;
+    result.blackKingsideRookMoved = castling.find('k') == std::string::npos;
+    result.blackQueensideRookMoved = castling.find('q') == std::string::npos;
+
+    // The en passant target square stands for the double pawn push that was just played
+    if (enPassant != "-") {
+        if (enPassant.size() != 2 || enPassant[0] < 'a' || enPassant[0] > 'h' ||
+            enPassant[1] != (result.sideToMove == WHITE ? '6' : '3')) return false;
+        int targetRow = '8' - enPassant[1], targetCol = enPassant[0] - 'a';
+        int direction = (result.sideToMove == WHITE) ? 1 : -1;
+        result.lastMove = { targetRow + direction, targetCol };
+        result.lastMoveStart = { targetRow - direction, targetCol };
+        result.lastMoveWasPawnDouble = true;
+    }
+
+    int halfmoves = 0, fullmoves = 1;
+    if (stream >> halfmoves) {
+        stream >> fullmoves;
+    }
+    result.halfmoveClock = std::max(halfmoves, 0);
+    result.fullmoveNumber = std::max(fullmoves, 1);
+
+    result.update_bitboards();
+    if (popcount(result.pieceBB[WHITE][KING]) != 1 || popcount(result.pieceBB[BLACK][KING]) != 1) return false;
+    // Move generation trusts the en passant square, so it must describe a double push that could have happened
+    if (result.lastMoveWasPawnDouble) {
+        const Piece& pushed = result.board[result.lastMove.first][result.lastMove.second];
+        int targetRow = (result.lastMove.first + result.lastMoveStart.first) / 2;
+        if (pushed.type != PAWN || pushed.color == result.sideToMove ||
+            result.board[targetRow][result.lastMove.second].type != EMPTY ||
+            result.board[result.lastMoveStart.first][result.lastMoveStart.second].type != EMPTY) return false;
+    }
+    result.hash = result.compute_hash();
+    *this = result;
     return true;
 }
 
+std::string ChessBoard::to_fen() const {
+    std::string fen;
+    for (int row = 0; row < NUM_TILES; row++) {
+        int empty = 0;
+        for (int col = 0; col < NUM_TILES; col++) {
+            const Piece& piece = board[row][col];
+            if (piece.type == EMPTY) {
+                empty++;
+                continue;
+            }
+            if (empty) fen += (char)('0' + empty);
+            empty = 0;
+            char letter = "kqrbnp"[piece.type];
+            fen += (piece.color == WHITE) ? (char)std::toupper(letter) : letter;
+        }
+        if (empty) fen += (char)('0' + empty);
+        if (row < NUM_TILES - 1) fen += '/';
+    }
+
+    fen += (sideToMove == WHITE) ? " w " : " b ";
+    std::string castling;
+    if (!whiteKingMoved && !whiteKingsideRookMoved) castling += 'K';
+    if (!whiteKingMoved && !whiteQueensideRookMoved) castling += 'Q';
+    if (!blackKingMoved && !blackKingsideRookMoved) castling += 'k';
+    if (!blackKingMoved && !blackQueensideRookMoved) castling += 'q';
+    fen += castling.empty() ? "-" : castling;
+
+    if (lastMoveWasPawnDouble) {
+        fen += ' ';
+        fen += (char)('a' + lastMove.second);
+        fen += (char)('8' - (lastMove.first + lastMoveStart.first) / 2);
+    } else {
+        fen += " -";
+    }
+    return fen + " " + std::to_string(halfmoveClock) + " " + std::to_string(fullmoveNumber);
+}
+
 std::string ChessBoard::move_to_string(const Move& move) const {
     char cols[] = "abcdefgh";
     std::string pieceStr = piece_to_string(board[move.destRow][move.destCol].type);
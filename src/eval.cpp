@@ -0,0 +1,136 @@
+#include "eval.h"
+#include <vector>
+
+const Bitboard FILE_A = 0x0101010101010101ULL;
+
+struct EvalEntry {
+    uint64_t key;
+    int32_t score;
+};
+
+// Both pawn sets are stored, so a hit is never a collision
+struct PawnEntry {
+    Bitboard white;
+    Bitboard black;
+    int32_t score;
+    bool valid;
+};
+
+// One set of tables per thread: lock-free and private to each search
+static thread_local std::vector<EvalEntry> evalCache;
+static thread_local std::vector<PawnEntry> pawnCache;
+static thread_local EvalStats stats;
+
+EvalStats EvalStats::operator-(const EvalStats& other) const {
+    EvalStats result;
+    result.evalProbes = evalProbes - other.evalProbes;
+    result.evalHits = evalHits - other.evalHits;
+    result.pawnProbes = pawnProbes - other.pawnProbes;
+    result.pawnHits = pawnHits - other.pawnHits;
+    return result;
+}
+
+EvalStats& EvalStats::operator+=(const EvalStats& other) {
+    evalProbes += other.evalProbes;
+    evalHits += other.evalHits;
+    pawnProbes += other.pawnProbes;
+    pawnHits += other.pawnHits;
+    return *this;
+}
+
+const EvalStats& eval_stats() {
+    return stats;
+}
+
+/** Adds one side's pawn terms to the counts, negated for Black; rows are counted from Black's back rank as on the board **/
+template<Color Us>
+static void count_pawn_terms(Bitboard ours, Bitboard theirs, EvalTerms& terms) {
+    const int sign = (Us == WHITE) ? 1 : -1;
+    for (int file = 0; file < 8; file++) {
+        Bitboard onFile = ours & (FILE_A << file);
+        if (!onFile) continue;
+        Bitboard adjacent = ((file > 0) ? FILE_A << (file - 1) : 0) | ((file < 7) ? FILE_A << (file + 1) : 0);
+        int count = popcount(onFile);
+        terms.doubledPawns += sign * (count - 1);
+        if (!(ours & adjacent)) terms.isolatedPawns += sign * count;
+
+        while (onFile) {
+            int square = pop_lsb(onFile);
+            int row = square / 8;
+            // Rows ahead of the pawn: above it for White, below it for Black
+            Bitboard ahead = (Us == WHITE) ? square_bb(row * 8) - 1 : ~((square_bb(row * 8 + 7) << 1) - 1);
+            if (!(theirs & ahead & ((FILE_A << file) | adjacent))) {
+                terms.passedPawns[(Us == WHITE) ? 7 - row : row] += sign;
+            }
+        }
+    }
+}
+
+static int pawn_score(const EvalTerms& terms) {
+    int score = -DOUBLED_PAWN_PENALTY * terms.doubledPawns - ISOLATED_PAWN_PENALTY * terms.isolatedPawns;
+    for (int rank = 0; rank < 8; rank++) {
+        score += PASSED_PAWN_BONUS[rank] * terms.passedPawns[rank];
+    }
+    return score;
+}
+
+EvalTerms evaluation_terms(const ChessBoard& board) {
+    EvalTerms terms;
+    for (int type = QUEEN; type <= PAWN; type++) {
+        terms.pieces[type] = popcount(board.pieceBB[WHITE][type]) - popcount(board.pieceBB[BLACK][type]);
+    }
+    Bitboard white = board.pieceBB[WHITE][PAWN], black = board.pieceBB[BLACK][PAWN];
+    count_pawn_terms<WHITE>(white, black, terms);
+    count_pawn_terms<BLACK>(black, white, terms);
+    return terms;
+}
+
+uint64_t eval_params_hash() {
+    std::vector<int> params(PIECE_VALUES, PIECE_VALUES + 6);
+    params.push_back(DOUBLED_PAWN_PENALTY);
+    params.push_back(ISOLATED_PAWN_PENALTY);
+    params.insert(params.end(), PASSED_PAWN_BONUS, PASSED_PAWN_BONUS + 8);
+    uint64_t hash = 0xCBF29CE484222325ULL; // FNV-1a over the values
+    for (int value : params) {
+        hash = (hash ^ (uint32_t)value) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+int evaluate_pawn_structure(const ChessBoard& board) {
+    if (pawnCache.empty()) pawnCache.resize(1 << PAWN_CACHE_BITS);
+    Bitboard white = board.pieceBB[WHITE][PAWN], black = board.pieceBB[BLACK][PAWN];
+    uint64_t index = (white * 0x9E3779B97F4A7C15ULL ^ black * 0xC2B2AE3D27D4EB4FULL) >> (64 - PAWN_CACHE_BITS);
+
+    PawnEntry& entry = pawnCache[index];
+    stats.pawnProbes++;
+    if (entry.valid && entry.white == white && entry.black == black) {
+        stats.pawnHits++;
+        return entry.score;
+    }
+    entry.white = white;
+    entry.black = black;
+    EvalTerms terms;
+    count_pawn_terms<WHITE>(white, black, terms);
+    count_pawn_terms<BLACK>(black, white, terms);
+    entry.score = pawn_score(terms);
+    entry.valid = true;
+    return entry.score;
+}
+
+bool eval_cache_probe(uint64_t key, int& score) {
+    if (evalCache.empty()) evalCache.resize(1 << EVAL_CACHE_BITS);
+    const EvalEntry& entry = evalCache[key >> (64 - EVAL_CACHE_BITS)];
+    stats.evalProbes++;
+    // A zero key marks an unused slot; a real position hashing to zero is merely never cached
+    if (entry.key != key || key == 0) return false;
+    stats.evalHits++;
+    score = entry.score;
+    return true;
+}
+
+void eval_cache_store(uint64_t key, int score) {
+    EvalEntry& entry = evalCache[key >> (64 - EVAL_CACHE_BITS)];
+    entry.key = key;
+    entry.score = score;
+}
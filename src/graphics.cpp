@@ -1,5 +1,6 @@
 #include "graphics.h"
 #include <SDL2/SDL_image.h>
+#include <algorithm>
 #include <iostream>
 
 const int NUM_TILES = 8;
@@ -74,21 +75,44 @@ void draw_button(SDL_Renderer* renderer, TTF_Font* font, int x, int y, int w, in
 }
 
 void draw_move_history(SDL_Renderer* renderer, TTF_Font* font, int x, int y, const ChessBoard& board) {
-    auto moveHistory = board.get_move_history_strings();
+    draw_text_lines(renderer, font, x, y, board.get_move_history_strings());
+}
+
+int draw_text_lines(SDL_Renderer* renderer, TTF_Font* font, int x, int y, const std::vector<std::string>& lines) {
     SDL_Color textColor = { 0, 0, 0, 255 }; // Black text
-    for (size_t i = 0; i < moveHistory.size(); ++i) {
-        SDL_Surface* textSurface = TTF_RenderText_Solid(font, moveHistory[i].c_str(), textColor);
+    for (const std::string& line : lines) {
+        if (line.empty()) {
+            y += TTF_FontLineSkip(font); // Nothing to render, but the line still takes its place
+            continue;
+        }
+        SDL_Surface* textSurface = TTF_RenderText_Solid(font, line.c_str(), textColor);
         SDL_Texture* textTexture = SDL_CreateTextureFromSurface(renderer, textSurface);
 
         int text_width = textSurface->w;
         int text_height = textSurface->h;
-        SDL_Rect textRect = { x, y + (int)i * text_height, text_width, text_height };
+        SDL_Rect textRect = { x, y, text_width, text_height };
 
         SDL_RenderCopy(renderer, textTexture, NULL, &textRect);
+        y += text_height;
 
         SDL_FreeSurface(textSurface);
         SDL_DestroyTexture(textTexture);
     }
+    return y;
+}
+
+void draw_eval_bar(SDL_Renderer* renderer, int x, int y, int w, int h, double whiteShare) {
+    // White's share fills from the bottom, the side White plays from
+    int whiteHeight = (int)(h * std::min(std::max(whiteShare, 0.0), 1.0) + 0.5);
+    SDL_Rect blackRect = { x, y, w, h - whiteHeight };
+    SDL_Rect whiteRect = { x, y + h - whiteHeight, w, whiteHeight };
+    SDL_SetRenderDrawColor(renderer, 40, 40, 40, 255);
+    SDL_RenderFillRect(renderer, &blackRect);
+    SDL_SetRenderDrawColor(renderer, 250, 250, 250, 255);
+    SDL_RenderFillRect(renderer, &whiteRect);
+    SDL_Rect border = { x, y, w, h };
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderDrawRect(renderer, &border);
 }
 
 SDL_Texture* load_texture(SDL_Renderer* renderer, const char* file) {
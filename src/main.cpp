@@ -8,13 +8,20 @@
 #include <chrono>
 #include <thread>
 #include <cstddef>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include "graphics.h"
 #include "board.h"
 #include "piece.h"
 #include "ai.h"
+#include "nnue.h"
+#include "notation.h"
+#include "trace.h"
 
 const int TILE_SIZE = 80;
+const int ANALYSIS_PLIES_SHOWN = 6; // Moves of each analysis line that fit beside the board
 
 bool is_white_turn = true;
 
@@ -59,11 +66,40 @@ void load_piece_textures(SDL_Renderer* renderer, std::map<PieceType, SDL_Texture
 	black_pieces[KING] = load_texture(renderer, "images/black_king.png");
 }
 
+/** Analysis score from White's point of view, as shown to the user: +0.35, or #3 / -#3 for mates **/
+std::string format_score(int whiteScore) {
+    char text[16];
+    if (is_mate_score(whiteScore)) {
+        int moves = std::abs(mate_in_moves(std::abs(whiteScore)));
+        std::snprintf(text, sizeof(text), "%s#%d", whiteScore > 0 ? "" : "-", moves);
+    } else {
+        std::snprintf(text, sizeof(text), "%+.2f", whiteScore / 100.0);
+    }
+    return text;
+}
+
+/** Header and one line per principal variation of the background analysis **/
+std::vector<std::string> analysis_text(const ChessBoard& board, const AnalysisInfo& info) {
+    std::vector<std::string> text;
+    if (info.lines.empty()) {
+        text.push_back("Analysing...");
+        return text;
+    }
+    text.push_back("Depth " + std::to_string(info.depth) + ", " + std::to_string(info.nodes / 1000) + "k nodes");
+    for (const AnalysisLine& line : info.lines) {
+        int whiteScore = (board.sideToMove == WHITE) ? line.score : -line.score;
+        std::vector<PackedMove> shown(line.pv.begin(), line.pv.begin() + std::min((int)line.pv.size(), ANALYSIS_PLIES_SHOWN));
+        text.push_back(format_score(whiteScore) + "  " + line_to_san(board, shown));
+    }
+    return text;
+}
+
 bool is_inside_button(int x, int y, int bx, int by, int bw, int bh) {
     return x >= bx && x <= bx + bw && y >= by && y <= by + bh;
 }
 
 void reset_game(ChessBoard& board, bool& game_started, bool& is_white_turn, bool& pieceSelected, int& selectedRow, int& selectedCol, std::vector<std::pair<int, int>>& valid_moves) {
+    stop_pondering();
     board = ChessBoard();
     game_started = false;
     is_white_turn = true;
@@ -124,56 +160,13 @@ void make_move(ChessBoard& board, int srcRow, int srcCol, int destRow, int destC
     Piece piece = board.board[srcRow][srcCol];
     std::cout << "Moving piece: " << piece.type << ", " << piece.color << std::endl;
 
-    // Record the move
-    board.record_move(srcRow, srcCol, destRow, destCol);
-
-    // Handle en passant capture
-    if (piece.type == PAWN && std::abs(destCol - srcCol) == 1 && board.board[destRow][destCol].type == EMPTY) {
-        if (piece.color == WHITE && srcRow == 3) {
-            board.board[srcRow][destCol] = { EMPTY, NONE };
-        } else if (piece.color == BLACK && srcRow == 4) {
-            board.board[srcRow][destCol] = { EMPTY, NONE };
-        }
-    }
-
-    // Handle castling
-    if (piece.type == KING && std::abs(destCol - srcCol) == 2) {
-        int rookSrcCol = (destCol > srcCol) ? 7 : 0;
-        int rookDestCol = (destCol > srcCol) ? destCol - 1 : destCol + 1;
-        board.board[destRow][rookDestCol] = board.board[destRow][rookSrcCol];
-        board.board[destRow][rookSrcCol] = { EMPTY, NONE };
-    }
-
-    // Update castling flags
-    if (piece.type == KING) {
-        if (piece.color == WHITE) board.whiteKingMoved = true;
-        else board.blackKingMoved = true;
-    }
-    else if (piece.type == ROOK) {
-        if (piece.color == WHITE) {
-            if (srcCol == 0) board.whiteQueensideRookMoved = true;
-            else if (srcCol == 7) board.whiteKingsideRookMoved = true;
-        }
-        else {
-            if (srcCol == 0) board.blackQueensideRookMoved = true;
-            else if (srcCol == 7) board.blackKingsideRookMoved = true;
-        }
-    }
-
-    // Pawn Promotion
     if (piece.type == PAWN && (destRow == 0 || destRow == 7)) {
-        piece.type = QUEEN;
         std::cout << "Pawn promoted to Queen!" << std::endl;
     }
 
-    // Make the move
-    board.board[destRow][destCol] = piece;
-    board.board[srcRow][srcCol] = { EMPTY, NONE };
-
-    // Update last move
-    board.lastMoveStart = {srcRow, srcCol};
-    board.lastMove = {destRow, destCol};
-    board.lastMoveWasPawnDouble = (piece.type == PAWN && std::abs(destRow - srcRow) == 2);
+    // Make the move; a new move invalidates anything left to redo
+    board.make_move(srcRow, srcCol, destRow, destCol, QUEEN);
+    board.redoHistory.clear();
 
     // Switch turns
     is_white_turn = !is_white_turn;
@@ -190,6 +183,78 @@ int main(int argc, char* args[]) {
     SDL_Window* window = NULL;
     SDL_Renderer* renderer = NULL;
 
+    // Optional neural network evaluation: chess --nnue <file>
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(args[i]) == "--nnue" && !nnue_load(args[i + 1])) {
+            return -1;
+        }
+    }
+    // The AI thinks on the player's time unless started with --no-ponder
+    for (int i = 1; i < argc; i++) {
+        if (std::string(args[i]) == "--no-ponder") {
+            set_pondering(false);
+        }
+    }
+    // Transposition table size, optionally shared with other engine processes: chess --hash MB --shared-hash NAME
+    size_t hashMb = TT_DEFAULT_MB;
+    std::string sharedHash;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(args[i]) == "--hash") {
+            hashMb = std::strtoull(args[i + 1], nullptr, 10);
+        } else if (std::string(args[i]) == "--shared-hash") {
+            sharedHash = args[i + 1];
+        }
+    }
+    if ((hashMb != TT_DEFAULT_MB || !sharedHash.empty()) && !set_hash(hashMb, sharedHash)) {
+        return -1;
+    }
+    // Search results kept between sessions: chess --hash-file FILE (loaded now, saved on exit or with S)
+    std::string hashFile;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(args[i]) == "--hash-file") {
+            hashFile = args[i + 1];
+        }
+    }
+    if (!hashFile.empty()) {
+        load_hash_file(hashFile); // A missing or stale file just means a cold start
+    }
+    // Record the AI's searches for tracedump: chess --trace FILE
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(args[i]) == "--trace" && !trace_start(args[i + 1])) {
+            return -1;
+        }
+    }
+    // Difficulty from 1 (weakest, cheapest) to 8: chess --level N
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(args[i]) == "--level") {
+            set_strength(std::atoi(args[i + 1]));
+        }
+    }
+    // Lines shown by the analysis mode: chess --multipv N
+    int analysisLines = 3;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(args[i]) == "--multipv") {
+            analysisLines = std::max(std::atoi(args[i + 1]), 1);
+        }
+    }
+    // Alternative engine: chess --engine mcts [--threads N]
+    int engineThreads = 1;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(args[i]) == "--threads") {
+            engineThreads = std::atoi(args[i + 1]);
+        }
+    }
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(args[i]) == "--engine") {
+            std::string engine = args[i + 1];
+            if (engine != "mcts" && engine != "alphabeta") {
+                printf("Unknown engine %s (expected alphabeta or mcts)\n", engine.c_str());
+                return -1;
+            }
+            set_engine(engine == "mcts" ? ENGINE_MCTS : ENGINE_ALPHA_BETA, engineThreads);
+        }
+    }
+
     if (!init(&window, &renderer)) {
         printf("Failed to initialize!\n");
         return -1;
@@ -205,6 +270,11 @@ int main(int argc, char* args[]) {
         printf("Failed to load font! TTF_Error: %s\n", TTF_GetError());
         return -1;
     }
+    TTF_Font* smallFont = TTF_OpenFont("fonts/WrittenBirthday.ttf", 16); // Analysis lines
+    if (smallFont == NULL) {
+        printf("Failed to load font! TTF_Error: %s\n", TTF_GetError());
+        return -1;
+    }
 
     std::map<PieceType, SDL_Texture*> white_pieces;
     std::map<PieceType, SDL_Texture*> black_pieces;
@@ -229,11 +299,23 @@ int main(int argc, char* args[]) {
     int undo_button_y = 120;
     int redo_button_x = 810;
     int redo_button_y = 120;
+    int level_button_x = 690;
+    int level_button_y = 190;
+    int analyze_button_x = 810;
+    int analyze_button_y = 190;
+    int panel_x = 668;
 
     while (!quit) {
         while (SDL_PollEvent(&e) != 0) {
             if (e.type == SDL_QUIT) {
                 quit = true;
+            } else if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_s && !hashFile.empty()) {
+                save_hash_file(hashFile);
+            } else if (e.type == SDL_KEYDOWN && e.key.keysym.sym >= SDLK_0 + MIN_STRENGTH_LEVEL &&
+                       e.key.keysym.sym <= SDLK_0 + MAX_STRENGTH_LEVEL) {
+                // Number keys pick a strength level directly
+                set_strength(e.key.keysym.sym - SDLK_0);
+                std::cout << "AI strength level " << get_strength() << std::endl;
             } else if (e.type == SDL_MOUSEBUTTONDOWN) {
                 int x, y;
                 SDL_GetMouseState(&x, &y);
@@ -244,6 +326,7 @@ int main(int argc, char* args[]) {
                     make_best_move(chessBoard);
                     is_white_turn = false;  // Switch to Black's turn after AI moves
                 } else if (is_inside_button(x, y, undo_button_x, undo_button_y, button_width, button_height)) {
+                    stop_pondering();  // The pondered position is no longer reachable
                     if (chessBoard.undo_last_move()) {  // Undo AI move
                         if (chessBoard.undo_last_move()) {  // Undo player move
                             is_white_turn = false;  // It's the player's turn again
@@ -252,6 +335,7 @@ int main(int argc, char* args[]) {
                         }
                     }
                 } else if (is_inside_button(x, y, redo_button_x, redo_button_y, button_width, button_height)) {
+                    stop_pondering();
                     if (chessBoard.redo_move()) {  // Redo player move
                         if (chessBoard.redo_move()) {  // Redo AI move
                             is_white_turn = false;  // It's the player's turn again
@@ -259,6 +343,12 @@ int main(int argc, char* args[]) {
                             chessBoard.undo_last_move();  // If we can't redo AI move, undo player move
                         }
                     }
+                } else if (is_inside_button(x, y, level_button_x, level_button_y, button_width, button_height)) {
+                    // Each click is one level stronger, wrapping around to the weakest
+                    set_strength(get_strength() == MAX_STRENGTH_LEVEL ? MIN_STRENGTH_LEVEL : get_strength() + 1);
+                    std::cout << "AI strength level " << get_strength() << std::endl;
+                } else if (is_inside_button(x, y, analyze_button_x, analyze_button_y, button_width, button_height)) {
+                    set_analysis(!analysis_enabled(), analysisLines);
                 } else if (is_inside_button(x, y, reset_button_x, reset_button_y, button_width, button_height)) {
                     reset_game(chessBoard, game_started, is_white_turn, pieceSelected, selectedRow, selectedCol, valid_moves);
                 } else if (game_started && !is_white_turn) {  // Only allow moves on Black's turn
@@ -293,6 +383,10 @@ int main(int argc, char* args[]) {
                         show_game_end_message(window, "Checkmate! White wins.", chessBoard, game_started, is_white_turn, pieceSelected, selectedRow, selectedCol, valid_moves);
                     } else if (is_stalemate(chessBoard, WHITE) || is_stalemate(chessBoard, BLACK)) {
                         show_game_end_message(window, "Stalemate! The game is a draw.", chessBoard, game_started, is_white_turn, pieceSelected, selectedRow, selectedCol, valid_moves);
+                    } else if (chessBoard.repetition_count() >= 2) {
+                        show_game_end_message(window, "Threefold repetition! The game is a draw.", chessBoard, game_started, is_white_turn, pieceSelected, selectedRow, selectedCol, valid_moves);
+                    } else if (chessBoard.is_fifty_move_draw()) {
+                        show_game_end_message(window, "Fifty-move rule! The game is a draw.", chessBoard, game_started, is_white_turn, pieceSelected, selectedRow, selectedCol, valid_moves);
                     }
                 }
             }
@@ -307,8 +401,33 @@ int main(int argc, char* args[]) {
         draw_button(renderer, font, reset_button_x, reset_button_y, button_width, button_height, "Reset");
         draw_button(renderer, font, undo_button_x, undo_button_y, button_width, button_height, "Undo");
         draw_button(renderer, font, redo_button_x, redo_button_y, button_width, button_height, "Redo");
-        draw_move_history(renderer, font, 650, 200, chessBoard);
+        std::string levelLabel = "Level " + std::to_string(get_strength());
+        draw_button(renderer, font, level_button_x, level_button_y, button_width, button_height, levelLabel.c_str());
+        draw_button(renderer, font, analyze_button_x, analyze_button_y, button_width, button_height,
+                    analysis_enabled() ? "Stop" : "Analyze");
+        int history_y = 260;
+        update_analysis(chessBoard); // Restarts the background search only if the position changed
+        if (analysis_enabled()) {
+            // The render loop only copies the latest finished iteration, so it never waits on the search
+            AnalysisInfo info = analysis_info();
+            double whiteShare = 0.5;
+            if (!info.lines.empty()) {
+                int whiteScore = (chessBoard.sideToMove == WHITE) ? info.lines[0].score : -info.lines[0].score;
+                whiteShare = is_mate_score(whiteScore) ? (whiteScore > 0 ? 1.0 : 0.0) : 1.0 / (1.0 + std::exp(-whiteScore / 250.0));
+            }
+            draw_eval_bar(renderer, 644, 0, 16, 8 * TILE_SIZE, whiteShare);
+            history_y = draw_text_lines(renderer, smallFont, panel_x, history_y, analysis_text(chessBoard, info)) + 10;
+        }
+        draw_move_history(renderer, font, panel_x, history_y, chessBoard);
         SDL_RenderPresent(renderer);
+        SDL_Delay(16); // About 60 frames a second; spinning would take a core from the analysis
+    }
+    set_analysis(false);
+    stop_pondering();
+    trace_stop();
+
+    if (!hashFile.empty()) {
+        save_hash_file(hashFile);
     }
 
     for (auto& texture : white_pieces) {
@@ -318,6 +437,7 @@ int main(int argc, char* args[]) {
         SDL_DestroyTexture(texture.second);
     }
 
+    TTF_CloseFont(smallFont);
     TTF_CloseFont(font);
     TTF_Quit();
     SDL_DestroyRenderer(renderer);
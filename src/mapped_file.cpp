@@ -0,0 +1,50 @@
+#include "mapped_file.h"
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+/** Maps the whole file read-only; pages are loaded by the kernel as they are touched **/
+bool MappedFile::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cout << "Unable to open " << path << std::endl;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        std::cout << "Unable to read the size of " << path << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    length = (size_t)info.st_size;
+    if (length > 0) {
+        void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            std::cout << "Unable to map " << path << std::endl;
+            ::close(fd);
+            length = 0;
+            return false;
+        }
+        // Files are read front to back, so ask for aggressive read-ahead
+        madvise(mapping, length, MADV_SEQUENTIAL);
+        bytes = static_cast<const char*>(mapping);
+    }
+    ::close(fd); // The mapping keeps the file alive
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes) {
+        munmap(const_cast<char*>(bytes), length);
+    }
+    bytes = nullptr;
+    length = 0;
+}
@@ -0,0 +1,320 @@
+#include "mcts.h"
+#include "see.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+enum MctsNodeState : uint8_t { NODE_UNEXPANDED, NODE_EXPANDING, NODE_EXPANDED };
+
+const int64_t VALUE_ONE = 1 << 16;   // Fixed-point 1.0 for the atomic value sums
+const int VIRTUAL_LOSS = 3;          // Losses charged to a path while a worker is still on it
+const double FPU_REDUCTION = 0.2;    // Unvisited children are assumed a little worse than their parent
+const double SCORE_SCALE = 400.0;    // Centipawns for a value of tanh(1)
+const double PRIOR_SCALE = 200.0;    // Centipawns of static exchange per unit of prior logit
+
+static void reset_node(MctsNode& node, PackedMove move, float prior) {
+    node.visits.store(0, std::memory_order_relaxed);
+    node.valueSum.store(0, std::memory_order_relaxed);
+    node.firstChild.store(0, std::memory_order_relaxed);
+    node.childCount.store(0, std::memory_order_relaxed);
+    node.state.store(NODE_UNEXPANDED, std::memory_order_relaxed);
+    node.move = move;
+    node.prior = prior;
+}
+
+static void copy_node(MctsNode& to, const MctsNode& from) {
+    to.firstChild.store(0);
+    to.visits.store(from.visits.load());
+    to.valueSum.store(from.valueSum.load());
+    to.childCount.store(from.childCount.load());
+    to.state.store(from.state.load());
+    to.move = from.move;
+    to.prior = from.prior;
+}
+
+MctsTree::MctsTree(size_t maxNodes) : nodeCapacity(std::max<size_t>(maxNodes, 2)) {}
+
+void MctsTree::clear() {
+    if (!nodes) nodes.reset(new MctsNode[nodeCapacity]);
+    used = 1; // Node 0 is never handed out, so a child index of 0 means "none"
+    hasRoot = false;
+}
+
+uint32_t MctsTree::allocate(uint32_t count) {
+    uint32_t first = used.fetch_add(count);
+    return (first + (size_t)count <= nodeCapacity) ? first : 0;
+}
+
+/** Moves the subtree under newRoot to the front of a fresh arena, dropping everything else **/
+void MctsTree::compact(uint32_t newRoot) {
+    if (!spare) spare.reset(new MctsNode[nodeCapacity]);
+    std::unique_ptr<MctsNode[]>& fresh = spare;
+    copy_node(fresh[1], nodes[newRoot]);
+    uint32_t next = 2;
+    std::vector<std::pair<uint32_t, uint32_t>> pending = { { newRoot, 1 } }; // (old index, new index)
+    while (!pending.empty()) {
+        auto [from, to] = pending.back();
+        pending.pop_back();
+        uint32_t count = nodes[from].childCount.load();
+        if (nodes[from].state.load() != NODE_EXPANDED || count == 0) continue;
+        fresh[to].firstChild.store(next);
+        uint32_t oldFirst = nodes[from].firstChild.load();
+        for (uint32_t i = 0; i < count; i++) {
+            copy_node(fresh[next + i], nodes[oldFirst + i]);
+            pending.push_back({ oldFirst + i, next + i });
+        }
+        next += count;
+    }
+    nodes.swap(fresh);
+    used = next;
+    root = 1;
+}
+
+void MctsTree::set_root(const ChessBoard& board) {
+    if (!nodes) clear();
+    if (hasRoot && rootBoard.hash == board.hash) return;
+
+    // The new position is usually the old root plus our move and the opponent's reply
+    uint32_t found = 0;
+    if (hasRoot && nodes[root].state.load() == NODE_EXPANDED) {
+        ChessBoard scratch = rootBoard;
+        uint32_t first = nodes[root].firstChild.load(), count = nodes[root].childCount.load();
+        for (uint32_t child = first; child < first + count && !found; child++) {
+            make_move(scratch, nodes[child].move);
+            if (scratch.hash == board.hash) {
+                found = child;
+            } else if (nodes[child].state.load() == NODE_EXPANDED) {
+                uint32_t grandFirst = nodes[child].firstChild.load(), grandCount = nodes[child].childCount.load();
+                for (uint32_t grandchild = grandFirst; grandchild < grandFirst + grandCount && !found; grandchild++) {
+                    make_move(scratch, nodes[grandchild].move);
+                    if (scratch.hash == board.hash) found = grandchild;
+                    scratch.unmake_move();
+                }
+            }
+            scratch.unmake_move();
+        }
+    }
+
+    if (found) {
+        compact(found);
+    } else {
+        clear();
+        root = allocate(1);
+        reset_node(nodes[root], NO_MOVE, 1.0f);
+    }
+    rootBoard = board;
+    hasRoot = true;
+}
+
+/** Shared state of one search; every worker runs playouts on its own copy of the board **/
+class MctsSearch {
+public:
+    MctsSearch(MctsTree& tree, const SearchLimits& limits, const MctsOptions& options, SearchControl* control)
+        : tree(tree), limits(limits), options(options), control(control),
+          startTime(std::chrono::steady_clock::now()) {
+        budget = limits.nodes ? limits.nodes : (limits.moveTimeMs ? 0 : MCTS_DEFAULT_PLAYOUTS);
+    }
+
+    void worker(ChessBoard board, uint32_t seed);
+    SearchResult result();
+
+private:
+    bool should_stop();
+    uint32_t select_child(const MctsNode& node);
+    double expand_and_evaluate(ChessBoard& board, uint32_t index, std::mt19937& rng);
+    double leaf_value(ChessBoard& board, std::mt19937& rng);
+
+    MctsTree& tree;
+    SearchLimits limits;
+    MctsOptions options;
+    SearchControl* control;
+    std::chrono::steady_clock::time_point startTime;
+    uint64_t budget;                      // Playouts, 0 for time-limited searches
+    std::atomic<uint64_t> playouts{0};
+    std::atomic<int> maxDepth{0};
+    std::mutex statsMutex;
+    EvalStats evalStats;
+};
+
+bool MctsSearch::should_stop() {
+    if (control && control->stop.load(std::memory_order_relaxed)) return true;
+    if (budget && playouts.load(std::memory_order_relaxed) >= budget) return true;
+    if (limits.moveTimeMs) {
+        auto elapsed = std::chrono::steady_clock::now() - startTime;
+        return std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() >= limits.moveTimeMs;
+    }
+    return false;
+}
+
+/** PUCT: the child's value for the side to move plus an exploration bonus weighted by its prior **/
+uint32_t MctsSearch::select_child(const MctsNode& node) {
+    int32_t parentVisits = node.visits.load(std::memory_order_relaxed);
+    double parentValue = parentVisits > 0 ? (double)node.valueSum.load(std::memory_order_relaxed) / VALUE_ONE / parentVisits : 0.0;
+    double firstPlayUrgency = -parentValue - FPU_REDUCTION;
+    double explorationScale = options.exploration * std::sqrt((double)std::max(parentVisits, 1));
+
+    uint32_t first = node.firstChild.load(std::memory_order_relaxed);
+    uint32_t count = node.childCount.load(std::memory_order_relaxed);
+    uint32_t best = first;
+    double bestScore = -1e9;
+    for (uint32_t i = first; i < first + count; i++) {
+        const MctsNode& child = tree.nodes[i];
+        int32_t visits = child.visits.load(std::memory_order_relaxed);
+        double value = visits > 0 ? (double)child.valueSum.load(std::memory_order_relaxed) / VALUE_ONE / visits : firstPlayUrgency;
+        double score = value + explorationScale * child.prior / (1 + visits);
+        if (score > bestScore) {
+            bestScore = score;
+            best = i;
+        }
+    }
+    return best;
+}
+
+/** Value of the position for the side to move, in [-1, 1] **/
+double MctsSearch::leaf_value(ChessBoard& board, std::mt19937& rng) {
+    // Optional random playout before the static assessment
+    int plies = 0;
+    double value = 0.0;
+    bool finished = false;
+    for (; plies < options.playoutPlies; plies++) {
+        if (board.repetition_count() > 0 || board.is_fifty_move_draw()) {
+            finished = true;
+            break;
+        }
+        MoveList moves;
+        generate_legal_moves(board, moves);
+        if (moves.empty()) {
+            value = is_check(board, board.sideToMove) ? -1.0 : 0.0;
+            finished = true;
+            break;
+        }
+        make_move(board, moves.moves[rng() % moves.size]);
+    }
+    if (!finished) {
+        value = std::tanh(quiescence_score(board) / SCORE_SCALE);
+    }
+    for (int i = 0; i < plies; i++) board.unmake_move();
+    return (plies % 2) ? -value : value;
+}
+
+/** Expands the leaf if no other worker is doing so, then values it for its side to move **/
+double MctsSearch::expand_and_evaluate(ChessBoard& board, uint32_t index, std::mt19937& rng) {
+    MctsNode& node = tree.nodes[index];
+    uint8_t expected = NODE_UNEXPANDED;
+    if (tree.used.load(std::memory_order_relaxed) < tree.nodeCapacity &&
+        node.state.compare_exchange_strong(expected, NODE_EXPANDING, std::memory_order_acquire)) {
+        MoveList moves;
+        generate_legal_moves(board, moves);
+        uint32_t first = moves.empty() ? 0 : tree.allocate(moves.size);
+        if (moves.empty() || first) {
+            // Priors from a softmax over static exchange results, so hanging pieces are explored last
+            float logits[256];
+            float total = 0.0f;
+            for (int i = 0; i < moves.size; i++) {
+                logits[i] = std::exp((float)std::clamp(see(board, moves.moves[i]) / PRIOR_SCALE, -3.0, 3.0));
+                total += logits[i];
+            }
+            for (int i = 0; i < moves.size; i++) {
+                reset_node(tree.nodes[first + i], moves.moves[i], logits[i] / total);
+            }
+            node.firstChild.store(first, std::memory_order_relaxed);
+            node.childCount.store((uint16_t)moves.size, std::memory_order_relaxed);
+            node.state.store(NODE_EXPANDED, std::memory_order_release);
+        } else {
+            node.state.store(NODE_UNEXPANDED, std::memory_order_release); // Arena full
+        }
+    }
+
+    if (node.state.load(std::memory_order_acquire) == NODE_EXPANDED && node.childCount.load() == 0) {
+        return is_check(board, board.sideToMove) ? -1.0 : 0.0;
+    }
+    return leaf_value(board, rng);
+}
+
+void MctsSearch::worker(ChessBoard board, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint32_t> path;
+    EvalStats before = eval_stats();
+
+    while (!should_stop()) {
+        // Selection, charging a virtual loss to every node on the path so other workers spread out
+        uint32_t index = tree.root;
+        path.assign(1, index);
+        tree.nodes[index].visits.fetch_add(VIRTUAL_LOSS, std::memory_order_relaxed);
+        tree.nodes[index].valueSum.fetch_sub(VIRTUAL_LOSS * VALUE_ONE, std::memory_order_relaxed);
+        bool draw = false;
+        while (tree.nodes[index].state.load(std::memory_order_acquire) == NODE_EXPANDED &&
+               tree.nodes[index].childCount.load(std::memory_order_relaxed) > 0) {
+            index = select_child(tree.nodes[index]);
+            make_move(board, tree.nodes[index].move);
+            path.push_back(index);
+            tree.nodes[index].visits.fetch_add(VIRTUAL_LOSS, std::memory_order_relaxed);
+            tree.nodes[index].valueSum.fetch_sub(VIRTUAL_LOSS * VALUE_ONE, std::memory_order_relaxed);
+            if (board.repetition_count() > 0 || board.is_fifty_move_draw()) {
+                draw = true;
+                break;
+            }
+        }
+
+        // Node values are kept for the side that moved into the node
+        double value = draw ? 0.0 : -expand_and_evaluate(board, index, rng);
+
+        // Backup, replacing the virtual losses with the real result
+        for (size_t i = path.size(); i-- > 0;) {
+            MctsNode& node = tree.nodes[path[i]];
+            node.visits.fetch_add(1 - VIRTUAL_LOSS, std::memory_order_relaxed);
+            node.valueSum.fetch_add((int64_t)(value * VALUE_ONE) + VIRTUAL_LOSS * VALUE_ONE, std::memory_order_relaxed);
+            value = -value;
+        }
+        for (size_t i = 1; i < path.size(); i++) board.unmake_move();
+
+        playouts.fetch_add(1, std::memory_order_relaxed);
+        int depth = (int)path.size() - 1, deepest = maxDepth.load(std::memory_order_relaxed);
+        while (depth > deepest && !maxDepth.compare_exchange_weak(deepest, depth)) {}
+    }
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    evalStats += eval_stats() - before;
+}
+
+/** The most visited root move, scored by its average value **/
+SearchResult MctsSearch::result() {
+    SearchResult result;
+    const MctsNode& root = tree.nodes[tree.root];
+    uint32_t first = root.firstChild.load(), count = root.childCount.load();
+    int32_t bestVisits = -1;
+    for (uint32_t i = first; i < first + count && root.state.load() == NODE_EXPANDED; i++) {
+        const MctsNode& child = tree.nodes[i];
+        if (child.visits.load() > bestVisits) {
+            bestVisits = child.visits.load();
+            result.bestMove = child.move;
+            double value = bestVisits ? (double)child.valueSum.load() / VALUE_ONE / bestVisits : 0.0;
+            result.score = (int)(SCORE_SCALE * std::atanh(std::clamp(value, -0.999, 0.999)));
+        }
+    }
+    result.depth = maxDepth.load();
+    result.nodes = playouts.load();
+    result.evalStats = evalStats;
+    return result;
+}
+
+SearchResult mcts_search(ChessBoard& board, const SearchLimits& limits, MctsTree& tree,
+                         const MctsOptions& options, SearchControl* control) {
+    MoveList moves;
+    generate_legal_moves(board, moves);
+    if (moves.empty()) return SearchResult();
+
+    tree.set_root(board);
+    MctsSearch search(tree, limits, options, control);
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < options.threads; i++) {
+        helpers.emplace_back(&MctsSearch::worker, &search, board, (uint32_t)(i * 7919 + 1));
+    }
+    search.worker(board, 1);
+    for (std::thread& helper : helpers) helper.join();
+    return search.result();
+}
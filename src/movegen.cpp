@@ -0,0 +1,284 @@
+#include "movegen.h"
+
+const Bitboard ROW_1 = 0xFFULL << 8;        // Black pawns start here
+const Bitboard ROW_6 = 0xFFULL << 48;       // White pawns start here
+const Bitboard COL_A = 0x0101010101010101ULL;
+const Bitboard COL_H = COL_A << 7;
+
+/** Color-dependent constants, folded at compile time **/
+template<Color Us>
+struct ColorTraits {
+    static constexpr int UP = (Us == WHITE) ? -8 : 8;
+    static constexpr int HOME_ROW = (Us == WHITE) ? 7 : 0;
+    static constexpr Bitboard START_ROW = (Us == WHITE) ? ROW_6 : ROW_1;
+    static constexpr Bitboard PROMOTION_ROW = (Us == WHITE) ? 0xFFULL : 0xFFULL << 56;
+
+    static Bitboard push(Bitboard b) { return (Us == WHITE) ? b >> 8 : b << 8; }
+    static bool king_moved(const ChessBoard& board) { return (Us == WHITE) ? board.whiteKingMoved : board.blackKingMoved; }
+    static bool kingside_rook_moved(const ChessBoard& board) {
+        return (Us == WHITE) ? board.whiteKingsideRookMoved : board.blackKingsideRookMoved;
+    }
+    static bool queenside_rook_moved(const ChessBoard& board) {
+        return (Us == WHITE) ? board.whiteQueensideRookMoved : board.blackQueensideRookMoved;
+    }
+};
+
+/** Checks that a pseudo-legal move does not leave our king attacked, without making it **/
+template<Color Us>
+bool is_legal(const ChessBoard& board, PackedMove move) {
+    constexpr Color Them = opposite(Us);
+    int src = move_src(move), dest = move_dest(move);
+    Bitboard occupied = (board.occupied() ^ square_bb(src)) | square_bb(dest);
+    Bitboard captured = square_bb(dest);
+
+    // En passant removes a pawn that is not on the destination square
+    if ((board.pieceBB[Us][PAWN] & square_bb(src)) && (src % 8) != (dest % 8) &&
+        board.board[dest / 8][dest % 8].type == EMPTY) {
+        int capturedSquare = (src / 8) * 8 + dest % 8;
+        occupied ^= square_bb(capturedSquare);
+        captured |= square_bb(capturedSquare);
+    }
+
+    int king = board.king_square(Us);
+    if (king == src) king = dest;
+    return !(attackers_to<Them>(board, king, occupied) & ~captured);
+}
+
+/** Adds a pawn move, keeping only the promotions and captures that belong to the requested stage **/
+template<Color Us, GenType Type>
+static void add_pawn_moves(MoveList& list, int src, int dest, bool capture) {
+    if (square_bb(dest) & ColorTraits<Us>::PROMOTION_ROW) {
+        if (Type != QUIETS) list.add(pack_move(src, dest, QUEEN));
+        if (Type != CAPTURES) {
+            list.add(pack_move(src, dest, ROOK));
+            list.add(pack_move(src, dest, BISHOP));
+            list.add(pack_move(src, dest, KNIGHT));
+        }
+    } else if (capture ? Type != QUIETS : Type != CAPTURES) {
+        list.add(pack_move(src, dest));
+    }
+}
+
+template<Color Us, GenType Type>
+static void generate_pawn_moves(const ChessBoard& board, MoveList& list) {
+    typedef ColorTraits<Us> T;
+    constexpr Color Them = opposite(Us);
+    Bitboard pawns = board.pieceBB[Us][PAWN];
+    Bitboard empty = ~board.occupied();
+
+    // Pushes are quiet except for promotions
+    Bitboard single = T::push(pawns) & empty;
+    if (Type == CAPTURES) single &= T::PROMOTION_ROW;
+    while (single) {
+        int dest = pop_lsb(single);
+        add_pawn_moves<Us, Type>(list, dest - T::UP, dest, false);
+    }
+    if (Type != CAPTURES) {
+        Bitboard twice = T::push(T::push(pawns & T::START_ROW) & empty) & empty;
+        while (twice) {
+            int dest = pop_lsb(twice);
+            list.add(pack_move(dest - 2 * T::UP, dest));
+        }
+    }
+
+    // Captures are all tactical except for underpromotions
+    Bitboard enemies = board.colorBB[Them];
+    if (board.lastMoveWasPawnDouble) {
+        enemies |= square_bb(board.lastMove.first * 8 + board.lastMove.second + T::UP);
+    }
+    if (Type == QUIETS) enemies &= T::PROMOTION_ROW;
+    Bitboard leftward = (T::push(pawns & ~COL_A) >> 1) & enemies;
+    Bitboard rightward = (T::push(pawns & ~COL_H) << 1) & enemies;
+    while (leftward) {
+        int dest = pop_lsb(leftward);
+        add_pawn_moves<Us, Type>(list, dest - T::UP + 1, dest, true);
+    }
+    while (rightward) {
+        int dest = pop_lsb(rightward);
+        add_pawn_moves<Us, Type>(list, dest - T::UP - 1, dest, true);
+    }
+}
+
+/** Squares a piece of the given type on square attacks; pawns are handled separately **/
+static Bitboard piece_attacks(PieceType type, int square, Bitboard occupied) {
+    switch (type) {
+        case KNIGHT: return ATTACKS.knight[square];
+        case BISHOP: return bishop_attacks(square, occupied);
+        case ROOK: return rook_attacks(square, occupied);
+        case QUEEN: return bishop_attacks(square, occupied) | rook_attacks(square, occupied);
+        default: return ATTACKS.king[square];
+    }
+}
+
+template<Color Us, PieceType Piece, GenType Type>
+static void generate_piece_moves(const ChessBoard& board, MoveList& list) {
+    Bitboard pieces = board.pieceBB[Us][Piece];
+    Bitboard occupied = board.occupied();
+    Bitboard allowed = (Type == CAPTURES) ? board.colorBB[opposite(Us)]
+                     : (Type == QUIETS) ? ~occupied
+                     : ~board.colorBB[Us];
+    while (pieces) {
+        int src = pop_lsb(pieces);
+        Bitboard targets = piece_attacks(Piece, src, occupied) & allowed;
+        while (targets) {
+            list.add(pack_move(src, pop_lsb(targets)));
+        }
+    }
+}
+
+template<Color Us>
+static void generate_castling(const ChessBoard& board, MoveList& list) {
+    typedef ColorTraits<Us> T;
+    constexpr Color Them = opposite(Us);
+    constexpr int KING_SQUARE = T::HOME_ROW * 8 + 4;
+    if (T::king_moved(board) || !(board.pieceBB[Us][KING] & square_bb(KING_SQUARE))) return;
+
+    Bitboard occupied = board.occupied();
+    if (attackers_to<Them>(board, KING_SQUARE, occupied)) return;
+
+    // The king may not pass through an attacked square; the destination is checked by is_legal
+    if (!T::kingside_rook_moved(board) && (board.pieceBB[Us][ROOK] & square_bb(KING_SQUARE + 3)) &&
+        !(occupied & ATTACKS.between[KING_SQUARE][KING_SQUARE + 3]) &&
+        !attackers_to<Them>(board, KING_SQUARE + 1, occupied)) {
+        list.add(pack_move(KING_SQUARE, KING_SQUARE + 2));
+    }
+    if (!T::queenside_rook_moved(board) && (board.pieceBB[Us][ROOK] & square_bb(KING_SQUARE - 4)) &&
+        !(occupied & ATTACKS.between[KING_SQUARE][KING_SQUARE - 4]) &&
+        !attackers_to<Them>(board, KING_SQUARE - 1, occupied)) {
+        list.add(pack_move(KING_SQUARE, KING_SQUARE - 2));
+    }
+}
+
+/** Generates the pseudo-legal moves of one stage (or all of them) for color Us **/
+template<Color Us, GenType Type>
+void generate_pseudo_moves(const ChessBoard& board, MoveList& list) {
+    generate_pawn_moves<Us, Type>(board, list);
+    generate_piece_moves<Us, KNIGHT, Type>(board, list);
+    generate_piece_moves<Us, BISHOP, Type>(board, list);
+    generate_piece_moves<Us, ROOK, Type>(board, list);
+    generate_piece_moves<Us, QUEEN, Type>(board, list);
+    generate_piece_moves<Us, KING, Type>(board, list);
+    if (Type != CAPTURES) generate_castling<Us>(board, list);
+}
+
+/** Generates all legal moves for color Us **/
+template<Color Us>
+void generate_legal_moves(const ChessBoard& board, MoveList& list) {
+    MoveList pseudo;
+    generate_pseudo_moves<Us, ALL>(board, pseudo);
+
+    for (PackedMove move : pseudo) {
+        if (is_legal<Us>(board, move)) {
+            list.add(move);
+        }
+    }
+}
+
+/** Whether a move from elsewhere (the table, a killer slot) is pseudo-legal in this position **/
+template<Color Us>
+bool is_pseudo_legal(const ChessBoard& board, PackedMove move) {
+    typedef ColorTraits<Us> T;
+    int src = move_src(move), dest = move_dest(move);
+    if (move == NO_MOVE || !(board.colorBB[Us] & square_bb(src)) || (board.colorBB[Us] & square_bb(dest))) return false;
+    if ((move >> 12) > KNIGHT) return false; // Only queen, rook, bishop and knight promotions are encodable moves
+
+    PieceType type = board.board[src / 8][src % 8].type;
+    bool promotion = move_promotion(move) != EMPTY;
+    if (type == PAWN) {
+        if (promotion != ((square_bb(dest) & T::PROMOTION_ROW) != 0)) return false;
+        Bitboard empty = ~board.occupied();
+        if (dest == src + T::UP) return (empty & square_bb(dest)) != 0;
+        if (dest == src + 2 * T::UP) {
+            return (T::START_ROW & square_bb(src)) && (empty & square_bb(src + T::UP)) && (empty & square_bb(dest));
+        }
+        Bitboard enemies = board.colorBB[opposite(Us)];
+        if (board.lastMoveWasPawnDouble) {
+            enemies |= square_bb(board.lastMove.first * 8 + board.lastMove.second + T::UP);
+        }
+        return (ATTACKS.pawn[Us][src] & enemies & square_bb(dest)) != 0;
+    }
+    if (promotion) return false;
+    if (type == KING && (dest == src + 2 || dest == src - 2)) {
+        MoveList castling;
+        generate_castling<Us>(board, castling);
+        for (PackedMove candidate : castling) {
+            if (candidate == move) return true;
+        }
+        return false;
+    }
+    return (piece_attacks(type, src, board.occupied()) & square_bb(dest)) != 0;
+}
+
+/** Generates the legal moves of one piece type to one square, without generating the rest **/
+template<Color Us>
+void generate_legal_moves_to(const ChessBoard& board, PieceType type, int dest, MoveList& list) {
+    if (board.colorBB[Us] & square_bb(dest)) return;
+
+    MoveList pseudo;
+    if (type == PAWN) {
+        generate_pawn_moves<Us, ALL>(board, pseudo);
+    } else {
+        // Sliders and leapers attack symmetrically, so look outward from the destination
+        Bitboard sources = piece_attacks(type, dest, board.occupied()) & board.pieceBB[Us][type];
+        while (sources) {
+            pseudo.add(pack_move(pop_lsb(sources), dest));
+        }
+        if (type == KING) generate_castling<Us>(board, pseudo);
+    }
+
+    for (PackedMove move : pseudo) {
+        if (move_dest(move) == dest && is_legal<Us>(board, move)) {
+            list.add(move);
+        }
+    }
+}
+
+void generate_legal_moves_to(const ChessBoard& board, PieceType type, int dest, MoveList& list) {
+    if (board.sideToMove == WHITE) {
+        generate_legal_moves_to<WHITE>(board, type, dest, list);
+    } else {
+        generate_legal_moves_to<BLACK>(board, type, dest, list);
+    }
+}
+
+void generate_legal_moves(const ChessBoard& board, MoveList& list) {
+    if (board.sideToMove == WHITE) {
+        generate_legal_moves<WHITE>(board, list);
+    } else {
+        generate_legal_moves<BLACK>(board, list);
+    }
+}
+
+template<Color Us>
+static uint64_t perft(ChessBoard& board, int depth) {
+    if (depth == 0) return 1;
+    MoveList moves;
+    generate_legal_moves<Us>(board, moves);
+    if (depth == 1) return moves.size;
+
+    uint64_t nodes = 0;
+    for (PackedMove move : moves) {
+        make_move(board, move);
+        nodes += perft<opposite(Us)>(board, depth - 1);
+        board.unmake_move();
+    }
+    return nodes;
+}
+
+/** Counts leaf nodes of the legal move tree, for validating and timing move generation **/
+uint64_t perft(ChessBoard& board, int depth) {
+    return board.sideToMove == WHITE ? perft<WHITE>(board, depth) : perft<BLACK>(board, depth);
+}
+
+template bool is_legal<WHITE>(const ChessBoard& board, PackedMove move);
+template bool is_legal<BLACK>(const ChessBoard& board, PackedMove move);
+template bool is_pseudo_legal<WHITE>(const ChessBoard& board, PackedMove move);
+template bool is_pseudo_legal<BLACK>(const ChessBoard& board, PackedMove move);
+template void generate_pseudo_moves<WHITE, CAPTURES>(const ChessBoard& board, MoveList& list);
+template void generate_pseudo_moves<WHITE, QUIETS>(const ChessBoard& board, MoveList& list);
+template void generate_pseudo_moves<BLACK, CAPTURES>(const ChessBoard& board, MoveList& list);
+template void generate_pseudo_moves<BLACK, QUIETS>(const ChessBoard& board, MoveList& list);
+template void generate_legal_moves<WHITE>(const ChessBoard& board, MoveList& list);
+template void generate_legal_moves<BLACK>(const ChessBoard& board, MoveList& list);
+template void generate_legal_moves_to<WHITE>(const ChessBoard& board, PieceType type, int dest, MoveList& list);
+template void generate_legal_moves_to<BLACK>(const ChessBoard& board, PieceType type, int dest, MoveList& list);
@@ -0,0 +1,122 @@
+#include "movepick.h"
+#include "see.h"
+
+bool is_tactical(const ChessBoard& board, PackedMove move) {
+    int src = move_src(move), dest = move_dest(move);
+    if (move_promotion(move) == QUEEN || board.board[dest / 8][dest % 8].type != EMPTY) return true;
+    // En passant: a pawn moving diagonally onto an empty square
+    return board.board[src / 8][src % 8].type == PAWN && src % 8 != dest % 8;
+}
+
+template<Color Us>
+MovePicker<Us>::MovePicker(const ChessBoard& board, PackedMove ttMove, const PackedMove killers[2])
+    : board(board), ttMove(ttMove) {
+    this->killers[0] = killers[0];
+    this->killers[1] = (killers[1] == killers[0]) ? NO_MOVE : killers[1];
+}
+
+template<Color Us>
+MovePicker<Us>::MovePicker(const ChessBoard& board)
+    : board(board), ttMove(NO_MOVE), stage(GENERATE_CAPTURES), quiescence(true) {
+    killers[0] = killers[1] = NO_MOVE;
+}
+
+template<Color Us>
+bool MovePicker<Us>::already_tried(PackedMove move) const {
+    return move == ttMove || move == killers[0] || move == killers[1];
+}
+
+template<Color Us>
+PackedMove MovePicker<Us>::next() {
+    while (true) {
+        switch (stage) {
+            case TT_MOVE:
+                stage = GENERATE_CAPTURES;
+                // The table move may come from a colliding position, so it is verified before use
+                if (is_pseudo_legal<Us>(board, ttMove) && is_legal<Us>(board, ttMove)) return ttMove;
+                ttMove = NO_MOVE;
+                break;
+
+            case GENERATE_CAPTURES:
+                moves.size = 0;
+                generate_pseudo_moves<Us, CAPTURES>(board, moves);
+                for (int i = 0; i < moves.size; i++) {
+                    // Most valuable victim first, least valuable attacker breaking ties
+                    int src = move_src(moves.moves[i]), dest = move_dest(moves.moves[i]);
+                    PieceType victim = board.board[dest / 8][dest % 8].type;
+                    PieceType attacker = board.board[src / 8][src % 8].type;
+                    scores[i] = 10 * SEE_VALUES[victim == EMPTY ? PAWN : victim] + attacker;
+                    if (move_promotion(moves.moves[i]) == QUEEN) scores[i] += 10 * SEE_VALUES[QUEEN];
+                }
+                current = 0;
+                stage = PICK_CAPTURES;
+                break;
+
+            case PICK_CAPTURES:
+                while (current < moves.size) {
+                    // Selection sort one move at a time; a cutoff leaves the rest unsorted
+                    int best = current;
+                    for (int i = current + 1; i < moves.size; i++) {
+                        if (scores[i] > scores[best]) best = i;
+                    }
+                    std::swap(moves.moves[current], moves.moves[best]);
+                    std::swap(scores[current], scores[best]);
+                    PackedMove move = moves.moves[current++];
+                    if (move == ttMove) continue;
+
+                    // Only a capture by a more valuable piece can lose material
+                    int src = move_src(move), dest = move_dest(move);
+                    if (SEE_VALUES[board.board[src / 8][src % 8].type] > SEE_VALUES[board.board[dest / 8][dest % 8].type] &&
+                        see(board, move) < 0) {
+                        if (!quiescence) badCaptures.add(move);
+                        continue;
+                    }
+                    if (is_legal<Us>(board, move)) return move;
+                }
+                stage = quiescence ? DONE : KILLERS;
+                break;
+
+            case KILLERS:
+                while (killerIndex < 2) {
+                    PackedMove& killer = killers[killerIndex++];
+                    if (killer != ttMove && is_pseudo_legal<Us>(board, killer) &&
+                        !is_tactical(board, killer) && is_legal<Us>(board, killer)) {
+                        return killer;
+                    }
+                    killer = NO_MOVE; // Not returned here, so the quiet stage must not skip it
+                }
+                stage = GENERATE_QUIETS;
+                break;
+
+            case GENERATE_QUIETS:
+                moves.size = 0;
+                generate_pseudo_moves<Us, QUIETS>(board, moves);
+                current = 0;
+                stage = PICK_QUIETS;
+                break;
+
+            case PICK_QUIETS:
+                while (current < moves.size) {
+                    PackedMove move = moves.moves[current++];
+                    if (!already_tried(move) && is_legal<Us>(board, move)) return move;
+                }
+                current = 0;
+                stage = PICK_BAD_CAPTURES;
+                break;
+
+            case PICK_BAD_CAPTURES:
+                while (current < badCaptures.size) {
+                    PackedMove move = badCaptures.moves[current++];
+                    if (is_legal<Us>(board, move)) return move;
+                }
+                stage = DONE;
+                break;
+
+            default:
+                return NO_MOVE;
+        }
+    }
+}
+
+template class MovePicker<WHITE>;
+template class MovePicker<BLACK>;
@@ -0,0 +1,195 @@
+#include "nnue.h"
+#include "board.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+const char NNUE_MAGIC[8] = { 'C', 'H', 'S', 'N', 'N', 'U', 'E', '1' };
+
+/** Network weights. Feature rows are indexed by (color * 6 + type) * 64 + square from White's view. **/
+struct NnueNetwork {
+    alignas(32) int16_t featureWeights[NNUE_INPUTS][NNUE_HIDDEN];
+    alignas(32) int16_t featureBias[NNUE_HIDDEN];
+    alignas(32) int8_t outputWeights[2 * NNUE_HIDDEN]; // Side to move's half first
+    int32_t outputBias;
+};
+
+typedef int32_t (*OutputKernel)(const int16_t* us, const int16_t* them, const int8_t* weights);
+
+static std::vector<NnueNetwork> network; // Empty until a network is loaded
+static uint32_t networkId = 0;
+static uint64_t networkChecksum = 0;
+static OutputKernel outputKernel = nullptr;
+static const char* kernelName = "none";
+
+/** Clipped ReLU followed by the int8 output layer, one scalar multiply-add at a time **/
+static int32_t output_scalar(const int16_t* us, const int16_t* them, const int8_t* weights) {
+    int32_t sum = 0;
+    for (int i = 0; i < NNUE_HIDDEN; i++) {
+        sum += std::min<int>(std::max<int>(us[i], 0), NNUE_QA) * weights[i];
+        sum += std::min<int>(std::max<int>(them[i], 0), NNUE_QA) * weights[NNUE_HIDDEN + i];
+    }
+    return sum;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/** Same computation with AVX2: clamp 32 int16 sums, pack to uint8 and multiply against int8 weights **/
+__attribute__((target("avx2")))
+static int32_t output_avx2(const int16_t* us, const int16_t* them, const int8_t* weights) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i limit = _mm256_set1_epi16(NNUE_QA);
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i total = _mm256_setzero_si256();
+
+    const int16_t* halves[2] = { us, them };
+    for (int half = 0; half < 2; half++) {
+        const int16_t* input = halves[half];
+        const int8_t* halfWeights = weights + half * NNUE_HIDDEN;
+        for (int i = 0; i < NNUE_HIDDEN; i += 32) {
+            __m256i a = _mm256_load_si256((const __m256i*)(input + i));
+            __m256i b = _mm256_load_si256((const __m256i*)(input + i + 16));
+            a = _mm256_min_epi16(_mm256_max_epi16(a, zero), limit);
+            b = _mm256_min_epi16(_mm256_max_epi16(b, zero), limit);
+            // packus interleaves 128-bit lanes; the permute restores input order
+            __m256i activations = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+            __m256i w = _mm256_load_si256((const __m256i*)(halfWeights + i));
+            __m256i products = _mm256_maddubs_epi16(activations, w);
+            total = _mm256_add_epi32(total, _mm256_madd_epi16(products, ones));
+        }
+    }
+
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(total), _mm256_extracti128_si256(total, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    return _mm_cvtsi128_si32(sum);
+}
+#endif
+
+static void select_kernel() {
+    outputKernel = output_scalar;
+    kernelName = "scalar";
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2")) {
+        outputKernel = output_avx2;
+        kernelName = "avx2";
+    }
+#endif
+}
+
+/** Loads a network file: magic, hidden size, then the little-endian weight arrays **/
+bool nnue_load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cout << "Unable to open network file " << path << std::endl;
+        return false;
+    }
+
+    char magic[8];
+    int32_t hidden = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&hidden), sizeof(hidden));
+    if (!file || std::memcmp(magic, NNUE_MAGIC, sizeof(magic)) != 0 || hidden != NNUE_HIDDEN) {
+        std::cout << "Network file " << path << " has the wrong format or size" << std::endl;
+        return false;
+    }
+
+    std::vector<NnueNetwork> loaded(1);
+    NnueNetwork& net = loaded[0];
+    file.read(reinterpret_cast<char*>(net.featureWeights), sizeof(net.featureWeights));
+    file.read(reinterpret_cast<char*>(net.featureBias), sizeof(net.featureBias));
+    file.read(reinterpret_cast<char*>(net.outputWeights), sizeof(net.outputWeights));
+    file.read(reinterpret_cast<char*>(&net.outputBias), sizeof(net.outputBias));
+    if (!file) {
+        std::cout << "Network file " << path << " is truncated" << std::endl;
+        return false;
+    }
+
+    // FNV-1a over the weights, so results saved with this network can be recognized later
+    networkChecksum = 0xCBF29CE484222325ULL;
+    auto mix = [](const void* bytes, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            networkChecksum = (networkChecksum ^ static_cast<const uint8_t*>(bytes)[i]) * 0x100000001B3ULL;
+        }
+    };
+    mix(net.featureWeights, sizeof(net.featureWeights));
+    mix(net.featureBias, sizeof(net.featureBias));
+    mix(net.outputWeights, sizeof(net.outputWeights));
+    mix(&net.outputBias, sizeof(net.outputBias));
+
+    network.swap(loaded);
+    networkId++;
+    select_kernel();
+    std::cout << "Loaded network " << path << " (" << kernelName << " kernel)" << std::endl;
+    return true;
+}
+
+bool nnue_enabled() {
+    return !network.empty();
+}
+
+uint32_t nnue_network_id() {
+    return networkId;
+}
+
+uint64_t nnue_network_checksum() {
+    return networkChecksum;
+}
+
+const char* nnue_kernel_name() {
+    return kernelName;
+}
+
+/** Input index of a piece as seen from one perspective; Black sees the board flipped with colors swapped **/
+static inline int feature_index(Color perspective, Piece piece, int square) {
+    if (perspective == BLACK) {
+        return ((1 - piece.color) * 6 + piece.type) * 64 + (square ^ 56);
+    }
+    return (piece.color * 6 + piece.type) * 64 + square;
+}
+
+void nnue_add_piece(NnueAccumulator& accumulator, Piece piece, int square) {
+    for (int perspective = 0; perspective < 2; perspective++) {
+        const int16_t* weights = network[0].featureWeights[feature_index((Color)perspective, piece, square)];
+        int16_t* values = accumulator.values[perspective];
+        for (int i = 0; i < NNUE_HIDDEN; i++) values[i] += weights[i];
+    }
+}
+
+void nnue_remove_piece(NnueAccumulator& accumulator, Piece piece, int square) {
+    for (int perspective = 0; perspective < 2; perspective++) {
+        const int16_t* weights = network[0].featureWeights[feature_index((Color)perspective, piece, square)];
+        int16_t* values = accumulator.values[perspective];
+        for (int i = 0; i < NNUE_HIDDEN; i++) values[i] -= weights[i];
+    }
+}
+
+/** Recomputes the accumulator from scratch **/
+void nnue_refresh(const ChessBoard& board, NnueAccumulator& accumulator) {
+    for (int perspective = 0; perspective < 2; perspective++) {
+        std::memcpy(accumulator.values[perspective], network[0].featureBias, sizeof(network[0].featureBias));
+    }
+    for (int color = 0; color < 2; color++) {
+        for (int type = 0; type < 6; type++) {
+            Bitboard pieces = board.pieceBB[color][type];
+            while (pieces) {
+                nnue_add_piece(accumulator, { (PieceType)type, (Color)color }, pop_lsb(pieces));
+            }
+        }
+    }
+    accumulator.network = networkId;
+}
+
+int nnue_evaluate(const ChessBoard& board) {
+    NnueAccumulator& accumulator = board.accumulator;
+    if (accumulator.network != networkId) {
+        nnue_refresh(board, accumulator);
+    }
+    Color us = board.sideToMove;
+    int32_t output = outputKernel(accumulator.values[us], accumulator.values[1 - us], network[0].outputWeights);
+    return (int)((int64_t)(output + network[0].outputBias) * NNUE_OUTPUT_SCALE / (NNUE_QA * NNUE_QB));
+}
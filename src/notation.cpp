@@ -0,0 +1,177 @@
+#include "notation.h"
+#include <cstdlib>
+
+static const char PROMOTION_LETTERS[] = "kqrbnp";
+
+std::string square_to_string(int square) {
+    std::string text;
+    text += (char)('a' + square % 8);
+    text += (char)('8' - square / 8);
+    return text;
+}
+
+/** Coordinate notation such as e2e4 or e7e8q **/
+std::string move_to_uci(PackedMove move) {
+    std::string text = square_to_string(move_src(move)) + square_to_string(move_dest(move));
+    if (move_promotion(move) != EMPTY) {
+        text += PROMOTION_LETTERS[move_promotion(move)];
+    }
+    return text;
+}
+
+/** Standard algebraic notation for a legal move, including check and mate suffixes **/
+std::string move_to_san(ChessBoard& board, PackedMove move) {
+    int src = move_src(move), dest = move_dest(move);
+    Piece piece = board.board[src / 8][src % 8];
+    bool capture = board.board[dest / 8][dest % 8].type != EMPTY ||
+                   (piece.type == PAWN && src % 8 != dest % 8);
+    std::string san;
+
+    if (piece.type == KING && std::abs(dest - src) == 2) {
+        san = (dest > src) ? "O-O" : "O-O-O";
+    } else if (piece.type == PAWN) {
+        if (capture) {
+            san += (char)('a' + src % 8);
+            san += 'x';
+        }
+        san += square_to_string(dest);
+        if (move_promotion(move) != EMPTY) {
+            san += '=';
+            san += piece_to_string(move_promotion(move));
+        }
+    } else {
+        san += piece_to_string(piece.type);
+
+        // Disambiguate between identical pieces that can reach the same square
+        MoveList moves;
+        generate_legal_moves(board, moves);
+        bool ambiguous = false, sameCol = false, sameRow = false;
+        for (PackedMove other : moves) {
+            int otherSrc = move_src(other);
+            if (move_dest(other) == dest && otherSrc != src &&
+                board.board[otherSrc / 8][otherSrc % 8].type == piece.type) {
+                ambiguous = true;
+                sameCol |= (otherSrc % 8 == src % 8);
+                sameRow |= (otherSrc / 8 == src / 8);
+            }
+        }
+        if (ambiguous) {
+            if (!sameCol) {
+                san += (char)('a' + src % 8);
+            } else if (!sameRow) {
+                san += (char)('8' - src / 8);
+            } else {
+                san += square_to_string(src);
+            }
+        }
+        if (capture) san += 'x';
+        san += square_to_string(dest);
+    }
+
+    make_move(board, move);
+    if (is_check(board, board.sideToMove)) {
+        MoveList replies;
+        generate_legal_moves(board, replies);
+        san += replies.empty() ? '#' : '+';
+    }
+    board.unmake_move();
+    return san;
+}
+
+/** SAN of each move of a line played from board, separated by spaces **/
+std::string line_to_san(const ChessBoard& board, const std::vector<PackedMove>& line) {
+    ChessBoard scratch = board;
+    std::string text;
+    for (PackedMove move : line) {
+        if (!text.empty()) text += ' ';
+        text += move_to_san(scratch, move);
+        make_move(scratch, move);
+    }
+    return text;
+}
+
+PackedMove parse_uci_move(const ChessBoard& board, const std::string& text) {
+    MoveList moves;
+    generate_legal_moves(board, moves);
+    for (PackedMove move : moves) {
+        if (move_to_uci(move) == text) {
+            return move;
+        }
+    }
+    return NO_MOVE;
+}
+
+static PieceType san_piece(char letter) {
+    switch (letter) {
+        case 'K': return KING;
+        case 'Q': return QUEEN;
+        case 'R': return ROOK;
+        case 'B': return BISHOP;
+        case 'N': return KNIGHT;
+        default: return EMPTY;
+    }
+}
+
+/** Resolves a SAN move (e4, Nbd7, exd8=Q+, O-O) against the legal moves of the position **/
+PackedMove parse_san(const ChessBoard& board, std::string_view san) {
+    // Check, mate and annotation suffixes carry no information about the move itself
+    while (!san.empty() && (san.back() == '+' || san.back() == '#' || san.back() == '!' || san.back() == '?')) {
+        san.remove_suffix(1);
+    }
+    if (san.empty()) return NO_MOVE;
+
+    if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0") {
+        int kingSquare = board.king_square(board.sideToMove);
+        int dest = kingSquare + (san.size() == 3 ? 2 : -2);
+        MoveList moves;
+        generate_legal_moves_to(board, KING, dest, moves);
+        for (PackedMove move : moves) {
+            if (move_src(move) == kingSquare) return move;
+        }
+        return NO_MOVE;
+    }
+
+    PieceType type = san_piece(san[0]);
+    if (type == EMPTY) {
+        type = PAWN;
+    } else {
+        san.remove_prefix(1);
+    }
+
+    PieceType promotion = EMPTY;
+    if (type == PAWN && !san.empty() && san_piece(san.back()) != EMPTY) {
+        promotion = san_piece(san.back());
+        san.remove_suffix(1);
+        if (!san.empty() && san.back() == '=') san.remove_suffix(1);
+    }
+    if (san.size() < 2) return NO_MOVE;
+
+    // Destination square last; what remains is an optional file, rank and capture mark
+    char destFile = san[san.size() - 2], destRank = san[san.size() - 1];
+    if (destFile < 'a' || destFile > 'h' || destRank < '1' || destRank > '8') return NO_MOVE;
+    int dest = ('8' - destRank) * 8 + (destFile - 'a');
+    san.remove_suffix(2);
+
+    int fromFile = -1, fromRow = -1;
+    bool capture = false;
+    for (char c : san) {
+        if (c >= 'a' && c <= 'h') fromFile = c - 'a';
+        else if (c >= '1' && c <= '8') fromRow = '8' - c;
+        else if (c == 'x' || c == ':') capture = true;
+        else return NO_MOVE;
+    }
+
+    // Only moves of this piece type to this square are generated, which keeps bulk PGN import fast
+    MoveList moves;
+    generate_legal_moves_to(board, type, dest, moves);
+    PackedMove found = NO_MOVE;
+    for (PackedMove move : moves) {
+        int src = move_src(move);
+        if ((fromFile >= 0 && src % 8 != fromFile) || (fromRow >= 0 && src / 8 != fromRow)) continue;
+        if (capture && board.board[dest / 8][dest % 8].type == EMPTY && (type != PAWN || src % 8 == dest % 8)) continue;
+        if (move_promotion(move) != EMPTY && move_promotion(move) != (promotion == EMPTY ? QUEEN : promotion)) continue;
+        if (found != NO_MOVE) return NO_MOVE;
+        found = move;
+    }
+    return found;
+}
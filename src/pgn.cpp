@@ -0,0 +1,236 @@
+#include "pgn.h"
+#include "movegen.h"
+#include "notation.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+const char PGN_INDEX_MAGIC[8] = { 'C', 'H', 'S', 'P', 'G', 'N', 'I', '2' }; // 2: castling hashed by rights
+
+/** Index file header, followed by the entry table and then the hashes **/
+struct PgnIndexHeader {
+    char magic[8];
+    uint64_t gameCount;
+    uint64_t hashCount;
+};
+
+static bool is_blank(const char* begin, const char* end) {
+    for (const char* c = begin; c < end; c++) {
+        if (*c != ' ' && *c != '\t' && *c != '\r' && *c != '\n') return false;
+    }
+    return true;
+}
+
+/** A game starts at the first tag line after movetext (or at the first tag line of the file).
+    Only lines are scanned here, so splitting runs at close to memory bandwidth. **/
+void scan_pgn_games(const char* data, size_t size, std::vector<PgnGameSpan>& games) {
+    const size_t none = (size_t)-1;
+    size_t pos = 0, start = none;
+    bool inMovetext = true, inComment = false;
+    while (pos < size) {
+        const char* newline = static_cast<const char*>(std::memchr(data + pos, '\n', size - pos));
+        size_t end = newline ? (size_t)(newline - data) + 1 : size;
+
+        if (!inComment && data[pos] == '[') {
+            if (inMovetext) {
+                if (start != none) games.push_back({ start, pos - start });
+                start = pos;
+                inMovetext = false;
+            }
+        } else if (!is_blank(data + pos, data + end)) {
+            inMovetext = true;
+            // A brace comment may span lines and contain lines that look like tags
+            if (inComment || std::memchr(data + pos, '{', end - pos)) {
+                for (size_t i = pos; i < end; i++) {
+                    if (data[i] == '{') inComment = true;
+                    else if (data[i] == '}') inComment = false;
+                }
+            }
+        }
+        pos = end;
+    }
+    if (start != none) games.push_back({ start, size - start });
+}
+
+static PgnResult parse_result(std::string_view text) {
+    if (text == "1-0") return RESULT_WHITE_WINS;
+    if (text == "0-1") return RESULT_BLACK_WINS;
+    if (text == "1/2-1/2") return RESULT_DRAW;
+    return RESULT_UNKNOWN;
+}
+
+static bool is_result_token(std::string_view token) {
+    return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+}
+
+/** Reads the tag pairs at the front of a game; returns the offset where the movetext begins **/
+static size_t parse_tags(std::string_view text, std::string_view& fen, PgnResult& result) {
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t lineEnd = text.find('\n', pos);
+        if (lineEnd == std::string_view::npos) lineEnd = text.size();
+        std::string_view line = text.substr(pos, lineEnd - pos);
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first != std::string_view::npos && line[first] != '[') break;
+
+        if (first != std::string_view::npos) {
+            size_t nameEnd = line.find(' ', first);
+            size_t open = line.find('"', first);
+            size_t close = line.rfind('"');
+            if (nameEnd != std::string_view::npos && open != std::string_view::npos && close > open) {
+                std::string_view name = line.substr(first + 1, nameEnd - first - 1);
+                std::string_view value = line.substr(open + 1, close - open - 1);
+                if (name == "FEN") fen = value;
+                else if (name == "Result") result = parse_result(value);
+            }
+        }
+        pos = lineEnd + 1;
+    }
+    return std::min(pos, text.size());
+}
+
+/** Replays the movetext SAN by SAN, skipping move numbers, comments, variations and NAGs **/
+bool replay_pgn_game(std::string_view text, ChessBoard& board, PgnGameInfo& info, std::vector<uint64_t>* hashes) {
+    info = PgnGameInfo();
+    std::string_view fen;
+    size_t pos = parse_tags(text, fen, info.result);
+
+    board = ChessBoard();
+    if (!fen.empty() && !board.load_fen(std::string(fen))) {
+        info.error = std::string(fen);
+        return false;
+    }
+    if (hashes) hashes->push_back(board.hash);
+
+    while (pos < text.size()) {
+        char c = text[pos];
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '.' || c == ')' || c == '}') {
+            pos++;
+        } else if (c == '{') {
+            size_t close = text.find('}', pos);
+            pos = (close == std::string_view::npos) ? text.size() : close + 1;
+        } else if (c == ';' || (c == '%' && (pos == 0 || text[pos - 1] == '\n'))) {
+            size_t newline = text.find('\n', pos);
+            pos = (newline == std::string_view::npos) ? text.size() : newline + 1;
+        } else if (c == '(') {
+            // Variations nest and may contain comments with parentheses of their own
+            int depth = 0;
+            for (; pos < text.size(); pos++) {
+                if (text[pos] == '{') {
+                    size_t close = text.find('}', pos);
+                    pos = (close == std::string_view::npos) ? text.size() - 1 : close;
+                } else if (text[pos] == '(') {
+                    depth++;
+                } else if (text[pos] == ')' && --depth == 0) {
+                    pos++;
+                    break;
+                }
+            }
+        } else {
+            size_t end = text.find_first_of(" \t\r\n{}();", pos);
+            if (end == std::string_view::npos) end = text.size();
+            std::string_view token = text.substr(pos, end - pos);
+            pos = end;
+
+            if (token[0] == '$') continue;
+            if (is_result_token(token)) {
+                if (info.result == RESULT_UNKNOWN) info.result = parse_result(token);
+                break;
+            }
+            // Move numbers may be glued to the move ("12.Nf3", "12...Nf6"); they are digits followed by at
+            // least one dot, so castling written with zeros ("0-0") is left alone
+            size_t digits = token.find_first_not_of("0123456789");
+            if (digits == std::string_view::npos) continue;
+            if (digits > 0 && token[digits] == '.') {
+                size_t moveStart = token.find_first_not_of('.', digits);
+                if (moveStart == std::string_view::npos) continue;
+                token.remove_prefix(moveStart);
+            }
+
+            PackedMove move = parse_san(board, token);
+            if (move == NO_MOVE) {
+                info.error = std::string(token);
+                return false;
+            }
+            make_move(board, move);
+            info.plies++;
+            if (hashes) hashes->push_back(board.hash);
+        }
+    }
+    info.ok = true;
+    return true;
+}
+
+bool PgnIndex::open(const std::string& path) {
+    entries = nullptr;
+    allHashes = nullptr;
+    gameCount = 0;
+    if (!file.open(path)) return false;
+
+    PgnIndexHeader header;
+    if (file.size() < sizeof(header)) {
+        std::cout << "Index file " << path << " is truncated" << std::endl;
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    // The counts come from the file, so each is bounded by the bytes left before it is multiplied
+    uint64_t available = file.size() - sizeof(header);
+    bool sized = header.gameCount <= available / sizeof(PgnIndexEntry) &&
+                 header.hashCount <= (available - header.gameCount * sizeof(PgnIndexEntry)) / sizeof(uint64_t) &&
+                 file.size() == sizeof(header) + header.gameCount * sizeof(PgnIndexEntry) + header.hashCount * sizeof(uint64_t);
+    if (std::memcmp(header.magic, PGN_INDEX_MAGIC, sizeof(header.magic)) != 0 || !sized) {
+        std::cout << "Index file " << path << " has the wrong format or size" << std::endl;
+        return false;
+    }
+
+    // The header and entries are multiples of 8 bytes, so both arrays are naturally aligned in the mapping
+    entries = reinterpret_cast<const PgnIndexEntry*>(file.data() + sizeof(header));
+    allHashes = reinterpret_cast<const uint64_t*>(entries + header.gameCount);
+    gameCount = header.gameCount;
+    return true;
+}
+
+bool PgnIndexWriter::open(const std::string& path, uint64_t games) {
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cout << "Unable to open " << path << " for writing" << std::endl;
+        return false;
+    }
+    entries.clear();
+    entries.reserve(games);
+    hashCount = 0;
+    // Hashes are streamed as games arrive; the header and entry table are filled in by finish()
+    out.seekp(sizeof(PgnIndexHeader) + games * sizeof(PgnIndexEntry));
+    return (bool)out;
+}
+
+void PgnIndexWriter::add(const PgnGameSpan& span, const PgnGameInfo& info, const uint64_t* hashes, size_t count) {
+    PgnIndexEntry entry;
+    entry.offset = span.offset;
+    entry.firstHash = hashCount;
+    entry.length = (uint32_t)span.length;
+    entry.plies = (uint16_t)(count ? count - 1 : 0);
+    entry.result = info.result;
+    entry.flags = info.ok ? 0 : PGN_INDEX_PARSE_ERROR;
+    entries.push_back(entry);
+
+    out.write(reinterpret_cast<const char*>(hashes), count * sizeof(uint64_t));
+    hashCount += count;
+}
+
+bool PgnIndexWriter::finish() {
+    PgnIndexHeader header;
+    std::memcpy(header.magic, PGN_INDEX_MAGIC, sizeof(header.magic));
+    header.gameCount = entries.size();
+    header.hashCount = hashCount;
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(PgnIndexEntry));
+    out.close();
+    if (!out) {
+        std::cout << "Failed to write the index file" << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,212 @@
+#include "pns.h"
+#include <algorithm>
+
+const uint32_t PN_INFINITY = 1u << 30; // Proof and disproof numbers saturate here
+
+/** Proof state of one position; pn is the proof number of "the attacker mates", dn its disproof number **/
+struct PnsValue {
+    uint32_t pn = 1;
+    uint32_t dn = 1;
+    uint16_t distance = 0;   // Plies to mate once proven
+    PackedMove move = NO_MOVE; // Once proven: the mating move, or the longest defense
+};
+
+struct PnsEntry {
+    uint64_t key = 0;
+    uint32_t work = 0;       // Positions expanded below this one, so expensive results are kept
+    PnsValue value;
+};
+
+static uint32_t saturate(uint64_t number) {
+    return (uint32_t)std::min<uint64_t>(number, PN_INFINITY);
+}
+
+/** Depth-first proof-number search (df-pn) with a direct-mapped table as its only memory **/
+class MateSolver {
+public:
+    MateSolver(Color attacker, const MateSolverOptions& options, SearchControl* control)
+        : attacker(attacker), options(options), control(control) {
+        size_t count = 1;
+        while (count * 2 * sizeof(PnsEntry) <= std::max<size_t>(options.hashMb, 1) * 1024 * 1024) count *= 2;
+        table.assign(count, PnsEntry());
+        mask = count - 1;
+        nodeLimit = options.nodes;
+    }
+
+    template<Color Us>
+    void search(ChessBoard& board, uint32_t pnThreshold, uint32_t dnThreshold, int ply, PnsValue& value);
+
+    bool probe(uint64_t key, PnsValue& value) const {
+        const PnsEntry& slot = table[key & mask];
+        if (slot.key != key || slot.work == 0) return false;
+        value = slot.value;
+        return true;
+    }
+
+    void store(uint64_t key, const PnsValue& value, uint64_t work) {
+        PnsEntry& slot = table[key & mask];
+        uint32_t newWork = (uint32_t)std::min<uint64_t>(work + 1, UINT32_MAX);
+        if (slot.key != key && slot.work > newWork) return;
+        slot.key = key;
+        slot.work = newWork;
+        slot.value = value;
+    }
+
+    Color attacker;
+    MateSolverOptions options;
+    SearchControl* control;
+    std::vector<PnsEntry> table;
+    uint64_t mask = 0;
+    uint64_t nodes = 0;
+    uint64_t nodeLimit = 0;
+    bool stopped = false;
+};
+
+struct PnsChild {
+    PackedMove move;
+    PnsValue value;          // Repetitions and fifty-move draws start disproven and are never searched
+};
+
+template<Color Us>
+void MateSolver::search(ChessBoard& board, uint32_t pnThreshold, uint32_t dnThreshold, int ply, PnsValue& value) {
+    const bool attacking = (Us == attacker);
+    const PnsValue disproven = { PN_INFINITY, 0, 0, NO_MOVE };
+    nodes++;
+    if (nodes >= nodeLimit || (control && control->stop.load(std::memory_order_relaxed))) stopped = true;
+
+    // Mates beyond the ply limit, or with too little material left, are out of reach
+    if (ply >= MAX_PNS_PLY || has_insufficient_material(board)) {
+        value = disproven;
+        return;
+    }
+
+    MoveList moves;
+    generate_legal_moves<Us>(board, moves);
+    std::vector<PnsChild> children;
+    children.reserve(moves.size);
+    for (int i = 0; i < moves.size; i++) {
+        PnsChild child = { moves.moves[i], PnsValue() };
+        make_move(board, child.move);
+        if (attacking && options.checksOnly && !in_check<opposite(Us)>(board)) {
+            board.unmake_move();
+            continue;
+        }
+        if (board.repetition_count() > 0 || board.is_fifty_move_draw()) {
+            child.value = disproven;
+        } else {
+            probe(board.hash, child.value);
+        }
+        board.unmake_move();
+        children.push_back(child);
+    }
+
+    if (children.empty()) {
+        // Mate if the defender has no moves in check; stalemate, or the attacker stuck, is no mate
+        bool mated = moves.empty() && !attacking && in_check<Us>(board);
+        value = mated ? PnsValue{ 0, PN_INFINITY, 0, NO_MOVE } : disproven;
+        store(board.hash, value, 0);
+        return;
+    }
+
+    uint64_t startNodes = nodes;
+    while (true) {
+        // The attacker needs one proven move, the defender needs every move proven against it
+        uint64_t sum = 0;
+        uint32_t best = PN_INFINITY, second = PN_INFINITY;
+        int bestIndex = 0;
+        for (int i = 0; i < (int)children.size(); i++) {
+            uint32_t minimized = attacking ? children[i].value.pn : children[i].value.dn;
+            sum += attacking ? children[i].value.dn : children[i].value.pn;
+            if (minimized < best) {
+                second = best;
+                best = minimized;
+                bestIndex = i;
+            } else if (minimized < second) {
+                second = minimized;
+            }
+        }
+        value.pn = attacking ? best : saturate(sum);
+        value.dn = attacking ? saturate(sum) : best;
+        if (value.pn >= pnThreshold || value.dn >= dnThreshold || stopped) break;
+
+        // Descend into the most promising child until it is no longer the most promising
+        PnsChild& child = children[bestIndex];
+        uint32_t childPn, childDn;
+        if (attacking) {
+            childPn = std::min<uint64_t>(pnThreshold, (uint64_t)second + 1);
+            childDn = saturate((uint64_t)dnThreshold - value.dn + child.value.dn);
+        } else {
+            childPn = saturate((uint64_t)pnThreshold - value.pn + child.value.pn);
+            childDn = std::min<uint64_t>(dnThreshold, (uint64_t)second + 1);
+        }
+        make_move(board, child.move);
+        search<opposite(Us)>(board, childPn, childDn, ply + 1, child.value);
+        board.unmake_move();
+    }
+
+    // Once proven, prefer the quickest mate and assume the defender resists the longest
+    value.distance = 0;
+    value.move = children[0].move;
+    if (value.pn == 0) {
+        int bestDistance = -1;
+        for (const PnsChild& child : children) {
+            if (child.value.pn != 0) continue;
+            bool better = attacking ? child.value.distance < bestDistance : child.value.distance > bestDistance;
+            if (bestDistance < 0 || better) {
+                bestDistance = child.value.distance;
+                value.move = child.move;
+            }
+        }
+        value.distance = (uint16_t)(bestDistance + 1);
+    } else {
+        uint32_t best = PN_INFINITY;
+        for (const PnsChild& child : children) {
+            uint32_t minimized = attacking ? child.value.pn : child.value.dn;
+            if (minimized < best) {
+                best = minimized;
+                value.move = child.move;
+            }
+        }
+    }
+    store(board.hash, value, nodes - startNodes);
+}
+
+/** Runs the solver on board for its side to move, as an OR node for the attacker **/
+static void search_position(MateSolver& solver, ChessBoard& board, PnsValue& value) {
+    if (board.sideToMove == WHITE) {
+        solver.search<WHITE>(board, PN_INFINITY, PN_INFINITY, 0, value);
+    } else {
+        solver.search<BLACK>(board, PN_INFINITY, PN_INFINITY, 0, value);
+    }
+}
+
+MateResult solve_mate(const ChessBoard& board, const MateSolverOptions& options, SearchControl* control) {
+    MateResult result;
+    MateSolver solver(board.sideToMove, options, control);
+    ChessBoard scratch = board;
+    PnsValue root;
+    search_position(solver, scratch, root);
+    result.nodes = solver.nodes;
+    if (root.pn != 0) {
+        result.status = (root.dn == 0 && !solver.stopped) ? MATE_DISPROVEN : MATE_UNKNOWN;
+        return result;
+    }
+    result.status = MATE_PROVEN;
+    result.mateIn = (root.distance + 1) / 2;
+
+    // Follow the stored moves; a position whose entry was overwritten is proven again, with a fresh budget
+    solver.nodeLimit = solver.nodes + options.nodes;
+    solver.stopped = false;
+    for (int ply = 0; ply < MAX_PNS_PLY; ply++) {
+        PnsValue value;
+        if (!solver.probe(scratch.hash, value) || value.pn != 0) {
+            value = PnsValue();
+            search_position(solver, scratch, value);
+        }
+        if (value.pn != 0 || value.move == NO_MOVE) break;
+        result.line.push_back(value.move);
+        make_move(scratch, value.move);
+    }
+    result.nodes = solver.nodes;
+    return result;
+}
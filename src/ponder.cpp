@@ -0,0 +1,50 @@
+#include "ponder.h"
+
+bool Ponderer::start(const ChessBoard& board, const SearchLimits& searchLimits) {
+    stop();
+
+    // The table's move for this position is the reply the last search expected
+    TTEntry entry;
+    if (!tt.probe(board.hash, entry) || entry.move == NO_MOVE) return false;
+    MoveList moves;
+    generate_legal_moves(board, moves);
+    bool legal = false;
+    for (PackedMove move : moves) legal |= (move == entry.move);
+    if (!legal) return false;
+
+    ponderBoard = board;
+    make_move(ponderBoard, entry.move);
+    ponderHash = ponderBoard.hash; // ponderBoard itself belongs to the search thread from here on
+    expected = entry.move;
+    limits = searchLimits;
+    ponderResult = SearchResult();
+    control.stop = false;
+    control.pondering = true;
+    thread = std::thread([this] {
+        ponderResult = search_best_move(ponderBoard, limits, &tt, &control);
+    });
+    return true;
+}
+
+bool Ponderer::finish(const ChessBoard& board, SearchResult& result) {
+    if (!active()) return false;
+    if (board.hash != ponderHash) {
+        stop();
+        return false;
+    }
+
+    // Ponder hit: the search now stops at its depth, node or time limit, counting the time already spent
+    control.pondering = false;
+    thread.join();
+    expected = NO_MOVE;
+    result = ponderResult;
+    return result.bestMove != NO_MOVE;
+}
+
+void Ponderer::stop() {
+    if (active()) {
+        control.stop = true;
+        thread.join();
+    }
+    expected = NO_MOVE;
+}
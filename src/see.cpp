@@ -0,0 +1,72 @@
+#include "see.h"
+#include <algorithm>
+
+// Least valuable attackers first
+const PieceType CAPTURE_ORDER[] = { PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING };
+
+/** Swap algorithm: gains[d] is the material balance if the exchange stops after capture d **/
+int see(const ChessBoard& board, PackedMove move) {
+    int src = move_src(move), dest = move_dest(move);
+    Piece mover = board.board[src / 8][src % 8];
+    PieceType victim = board.board[dest / 8][dest % 8].type;
+    Bitboard occupied = board.occupied() ^ square_bb(src);
+
+    // En passant takes a pawn that is not on the destination square
+    if (mover.type == PAWN && victim == EMPTY && src % 8 != dest % 8) {
+        victim = PAWN;
+        occupied ^= square_bb((src / 8) * 8 + dest % 8);
+    }
+
+    int gains[32];
+    gains[0] = SEE_VALUES[victim];
+    PieceType onSquare = mover.type;
+    if (move_promotion(move) != EMPTY) {
+        onSquare = move_promotion(move);
+        gains[0] += SEE_VALUES[onSquare] - SEE_VALUES[PAWN];
+    }
+
+    Bitboard diagonal = board.pieceBB[WHITE][BISHOP] | board.pieceBB[BLACK][BISHOP] |
+                        board.pieceBB[WHITE][QUEEN] | board.pieceBB[BLACK][QUEEN];
+    Bitboard straight = board.pieceBB[WHITE][ROOK] | board.pieceBB[BLACK][ROOK] |
+                        board.pieceBB[WHITE][QUEEN] | board.pieceBB[BLACK][QUEEN];
+    Bitboard attackers = (attackers_to<WHITE>(board, dest, occupied) | attackers_to<BLACK>(board, dest, occupied)) & occupied;
+
+    Color side = opposite(mover.color);
+    int depth = 0;
+    while (depth < 31) {
+        depth++;
+        gains[depth] = SEE_VALUES[onSquare] - gains[depth - 1];
+        // Neither side can improve on stopping here
+        if (std::max(-gains[depth - 1], gains[depth]) < 0) break;
+
+        Bitboard ours = attackers & board.colorBB[side];
+        if (!ours) break;
+        PieceType attacker = KING;
+        for (PieceType type : CAPTURE_ORDER) {
+            if (ours & board.pieceBB[side][type]) {
+                attacker = type;
+                break;
+            }
+        }
+        // The king may only recapture if nothing defends the square any more
+        if (attacker == KING && (attackers & board.colorBB[opposite(side)])) break;
+
+        occupied ^= square_bb(lsb(ours & board.pieceBB[side][attacker]));
+        // Removing a piece can uncover a slider behind it on the same line
+        if (attacker == PAWN || attacker == BISHOP || attacker == QUEEN) {
+            attackers |= bishop_attacks(dest, occupied) & diagonal;
+        }
+        if (attacker == ROOK || attacker == QUEEN) {
+            attackers |= rook_attacks(dest, occupied) & straight;
+        }
+        attackers &= occupied;
+        onSquare = attacker;
+        side = opposite(side);
+    }
+
+    // The last gain has no recapture behind it; fold the rest back to the first capture
+    while (--depth) {
+        gains[depth - 1] = -std::max(-gains[depth - 1], gains[depth]);
+    }
+    return gains[0];
+}
@@ -0,0 +1,267 @@
+#include "session.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include "movegen.h"
+#include "notation.h"
+
+/** PGN-style result of the game, "*" while it is still in progress **/
+static const char* game_result(const ChessBoard& board) {
+    MoveList moves;
+    generate_legal_moves(board, moves);
+    if (moves.empty()) {
+        if (!is_check(board, board.sideToMove)) return "1/2-1/2";
+        return (board.sideToMove == WHITE) ? "0-1" : "1-0";
+    }
+    if (board.repetition_count() >= 2 || board.is_fifty_move_draw() || has_insufficient_material(board)) {
+        return "1/2-1/2";
+    }
+    return "*";
+}
+
+static bool parse_id(const std::string& text, uint64_t& id) {
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) return false;
+    id = std::strtoull(text.c_str(), nullptr, 10);
+    return true;
+}
+
+static std::string error_reply(const std::string& id, const std::string& reason) {
+    return "error " + (id.empty() ? "-" : id) + " " + reason;
+}
+
+SessionServer::SessionServer(const SessionServerOptions& options)
+    : options(options), pool(options.workers, options.maxQueued) {
+    latencies.reserve(SESSION_LATENCY_SAMPLES);
+}
+
+SessionServer::~SessionServer() {
+    // Cut running searches short; the pool then drains the queue quickly as it is destroyed
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& entry : sessions) {
+        entry.second->control.stop = true;
+    }
+}
+
+void SessionServer::handle(const std::string& request, const Reply& reply) {
+    std::istringstream args(request);
+    std::string command, idText;
+    args >> command;
+    if (command.empty()) return;
+    if (command == "new") {
+        reply(new_session(args));
+        return;
+    }
+    if (command == "stats") {
+        reply(stats());
+        return;
+    }
+
+    uint64_t id = 0;
+    args >> idText;
+    if (!parse_id(idText, id)) {
+        reply(error_reply(idText, "expected a session id"));
+        return;
+    }
+    if (command == "move") {
+        std::string move;
+        args >> move;
+        reply(make_player_move(id, move));
+    } else if (command == "go") {
+        std::string error = start_search(id, reply);
+        if (!error.empty()) reply(error);
+    } else if (command == "level") {
+        int level = 0;
+        args >> level;
+        reply(set_level(id, level));
+    } else if (command == "state") {
+        reply(describe(id));
+    } else if (command == "end") {
+        reply(end_session(id));
+    } else {
+        reply(error_reply(idText, "unknown command " + command));
+    }
+}
+
+std::string SessionServer::new_session(std::istringstream& args) {
+    auto session = std::make_shared<Session>();
+    session->moveTimeMs = options.defaultMoveTimeMs;
+
+    // An optional time budget, then an optional FEN in the rest of the line
+    std::string word, fen;
+    if (args >> word) {
+        if (word.find_first_not_of("0123456789") == std::string::npos) {
+            session->moveTimeMs = std::min(std::max(std::atoi(word.c_str()), 1), options.maxMoveTimeMs);
+        } else {
+            fen = word;
+        }
+        std::string rest;
+        std::getline(args, rest);
+        fen += rest;
+    }
+    size_t start = fen.find_first_not_of(' ');
+    if (start != std::string::npos && !session->board.load_fen(fen.substr(start))) {
+        return error_reply("", "invalid position");
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (sessions.size() >= options.maxSessions) return error_reply("", "too many sessions");
+    uint64_t id = nextId++;
+    sessions[id] = session;
+    return "ok " + std::to_string(id);
+}
+
+std::string SessionServer::make_player_move(uint64_t id, const std::string& text) {
+    std::string idText = std::to_string(id);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = sessions.find(id);
+    if (found == sessions.end()) return error_reply(idText, "no such session");
+    Session& session = *found->second;
+    if (session.searching) return error_reply(idText, "busy");
+    if (std::string(game_result(session.board)) != "*") return error_reply(idText, "game over");
+
+    PackedMove move = parse_uci_move(session.board, text);
+    if (move == NO_MOVE) move = parse_san(session.board, text);
+    if (move == NO_MOVE) return error_reply(idText, "illegal move " + text);
+    make_move(session.board, move);
+    return "ok " + idText + " " + game_result(session.board);
+}
+
+/** Searches a copy of the session's board on a worker; the move is applied once the search is done **/
+std::string SessionServer::start_search(uint64_t id, const Reply& reply) {
+    std::string idText = std::to_string(id);
+    auto requested = std::chrono::steady_clock::now();
+    std::shared_ptr<Session> session;
+    ChessBoard board;
+    int level;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = sessions.find(id);
+        if (found == sessions.end()) return error_reply(idText, "no such session");
+        session = found->second;
+        if (session->searching) return error_reply(idText, "busy");
+        if (std::string(game_result(session->board)) != "*") return error_reply(idText, "game over");
+        session->searching = true;
+        searching++;
+        board = session->board;
+        level = session->level;
+    }
+
+    SearchLimits limits;
+    limits.depth = MAX_SEARCH_DEPTH;
+    limits.moveTimeMs = session->moveTimeMs;
+    if (level) {
+        // The level's budgets apply within the session's time budget
+        limits = strength_limits(level);
+        if (!limits.moveTimeMs || limits.moveTimeMs > session->moveTimeMs) limits.moveTimeMs = session->moveTimeMs;
+        limits.noiseSeed = (uint64_t)requested.time_since_epoch().count();
+    }
+    bool queued = pool.try_submit([this, id, idText, session, board, limits, reply, requested]() mutable {
+        SearchResult result = search_best_move(board, limits, nullptr, &session->control);
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - requested).count();
+
+        std::string response;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            session->searching = false;
+            searching--;
+            if (sessions.count(id) == 0) {
+                response = error_reply(idText, "ended");
+            } else if (result.bestMove == NO_MOVE) {
+                response = error_reply(idText, "search stopped");
+            } else {
+                make_move(session->board, result.bestMove);
+                record_latency(milliseconds);
+                response = "bestmove " + idText + " " + move_to_uci(result.bestMove) + " " +
+                           std::to_string(result.score) + " " + std::to_string((int)milliseconds);
+            }
+        }
+        reply(response);
+    });
+    if (!queued) {
+        std::lock_guard<std::mutex> lock(mutex);
+        session->searching = false;
+        searching--;
+        return error_reply(idText, "busy");
+    }
+    return "";
+}
+
+std::string SessionServer::set_level(uint64_t id, int level) {
+    std::string idText = std::to_string(id);
+    if (level < MIN_STRENGTH_LEVEL || level > MAX_STRENGTH_LEVEL) {
+        return error_reply(idText, "level must be " + std::to_string(MIN_STRENGTH_LEVEL) + " to " +
+                                   std::to_string(MAX_STRENGTH_LEVEL));
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = sessions.find(id);
+    if (found == sessions.end()) return error_reply(idText, "no such session");
+    found->second->level = level; // A running search keeps the level it started with
+    return "ok " + idText;
+}
+
+std::string SessionServer::describe(uint64_t id) {
+    std::string idText = std::to_string(id);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = sessions.find(id);
+    if (found == sessions.end()) return error_reply(idText, "no such session");
+    const ChessBoard& board = found->second->board;
+    return "state " + idText + " " + game_result(board) + " " + board.to_fen();
+}
+
+std::string SessionServer::end_session(uint64_t id) {
+    std::string idText = std::to_string(id);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = sessions.find(id);
+    if (found == sessions.end()) return error_reply(idText, "no such session");
+    found->second->control.stop = true; // A running search answers "ended"
+    sessions.erase(found);
+    return "ok " + idText;
+}
+
+void SessionServer::record_latency(double milliseconds) {
+    if (latencies.size() < SESSION_LATENCY_SAMPLES) {
+        latencies.push_back((float)milliseconds);
+    } else {
+        latencies[movesAnswered % SESSION_LATENCY_SAMPLES] = (float)milliseconds;
+    }
+    movesAnswered++;
+}
+
+LatencyReport SessionServer::latency() const {
+    std::vector<float> samples;
+    LatencyReport report;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        samples = latencies;
+        report.moves = movesAnswered;
+    }
+    if (samples.empty()) return report;
+    auto percentile = [&samples](double fraction) {
+        size_t index = std::min(samples.size() - 1, (size_t)(fraction * samples.size()));
+        std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+        return (double)samples[index];
+    };
+    report.p50Ms = percentile(0.50);
+    report.p99Ms = percentile(0.99);
+    report.maxMs = *std::max_element(samples.begin(), samples.end());
+    return report;
+}
+
+size_t SessionServer::session_count() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return sessions.size();
+}
+
+std::string SessionServer::stats() {
+    LatencyReport report = latency();
+    size_t active, running;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        active = sessions.size();
+        running = searching;
+    }
+    std::ostringstream out;
+    out << "stats sessions " << active << " searching " << running << " moves " << report.moves
+        << " p50 " << report.p50Ms << " p99 " << report.p99Ms << " max " << report.maxMs;
+    return out.str();
+}
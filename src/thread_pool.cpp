@@ -0,0 +1,69 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(int threads, size_t maxQueued) : maxQueued(maxQueued) {
+    if (threads < 1) threads = 1;
+    for (int i = 0; i < threads; i++) {
+        workers.emplace_back(&ThreadPool::worker_loop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    std::unique_lock<std::mutex> lock(mutex);
+    spaceAvailable.wait(lock, [this] { return maxQueued == 0 || tasks.size() < maxQueued; });
+    tasks.push_back(std::move(task));
+    lock.unlock();
+    taskAvailable.notify_one();
+}
+
+bool ThreadPool::try_submit(std::function<void()> task) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (maxQueued != 0 && tasks.size() >= maxQueued) {
+        return false;
+    }
+    tasks.push_back(std::move(task));
+    lock.unlock();
+    taskAvailable.notify_one();
+    return true;
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    allDone.wait(lock, [this] { return tasks.empty() && running == 0; });
+}
+
+int ThreadPool::default_threads() {
+    unsigned int threads = std::thread::hardware_concurrency();
+    return threads ? (int)threads : 1;
+}
+
+void ThreadPool::worker_loop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            taskAvailable.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+            running++;
+        }
+        spaceAvailable.notify_one();
+        task();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running--;
+            if (tasks.empty() && running == 0) allDone.notify_all();
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#include "trace.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> traceActive{false};
+
+static std::mutex traceMutex;          // Guards the file; blocks from different threads must not mix
+static std::FILE* traceFile = nullptr;
+static std::atomic<uint64_t> traceGeneration{0}; // Bumped by every start, so buffers from an earlier trace are dropped
+static std::atomic<uint32_t> nextThread{0};
+
+/** Events of one thread since its last block was written **/
+struct TraceBuffer {
+    uint32_t thread = nextThread.fetch_add(1);
+    uint64_t generation = 0;
+    std::vector<TraceRecord> records;
+
+    ~TraceBuffer() { flush(); }
+
+    void flush() {
+        if (records.empty()) return;
+        std::lock_guard<std::mutex> lock(traceMutex);
+        if (traceFile && generation == traceGeneration) {
+            TraceBlock block = { thread, (uint32_t)records.size() };
+            std::fwrite(&block, sizeof(block), 1, traceFile);
+            std::fwrite(records.data(), sizeof(TraceRecord), records.size(), traceFile);
+        }
+        records.clear();
+    }
+};
+
+static thread_local TraceBuffer buffer;
+
+static int16_t clamp_score(int score) {
+    return (int16_t)std::min(std::max(score, -32767), 32767);
+}
+
+bool trace_start(const std::string& path) {
+    trace_stop();
+    std::lock_guard<std::mutex> lock(traceMutex);
+    traceFile = std::fopen(path.c_str(), "wb");
+    if (!traceFile) {
+        std::cout << "Unable to write trace file " << path << std::endl;
+        return false;
+    }
+    TraceFileHeader header;
+    std::memcpy(header.magic, TRACE_FILE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_FILE_VERSION;
+    header.recordSize = sizeof(TraceRecord);
+    std::fwrite(&header, sizeof(header), 1, traceFile);
+    traceGeneration++;
+    traceActive = true;
+    return true;
+}
+
+void trace_stop() {
+    if (!traceActive.exchange(false)) return;
+    buffer.flush();
+    std::lock_guard<std::mutex> lock(traceMutex);
+    std::fclose(traceFile);
+    traceFile = nullptr;
+}
+
+void trace_record(TraceEvent event, int ply, int depth, int index, PackedMove move, int score, int alpha, int beta,
+                  uint64_t key) {
+    if (buffer.generation != traceGeneration) {
+        buffer.records.clear();
+        buffer.generation = traceGeneration;
+    }
+    if (buffer.records.capacity() < TRACE_BUFFER_RECORDS) buffer.records.reserve(TRACE_BUFFER_RECORDS);
+    TraceRecord record;
+    record.event = event;
+    record.ply = (uint8_t)std::min(ply, 255);
+    record.depth = (int8_t)std::min(std::max(depth, -128), 127);
+    record.index = (uint8_t)std::min(index, 255);
+    record.move = move;
+    record.score = clamp_score(score);
+    record.alpha = clamp_score(alpha);
+    record.beta = clamp_score(beta);
+    record.key = (uint32_t)key;
+    buffer.records.push_back(record);
+    if (buffer.records.size() >= TRACE_BUFFER_RECORDS) buffer.flush();
+}
+
+void trace_flush_thread() {
+    if (traceActive.load(std::memory_order_relaxed)) buffer.flush();
+}
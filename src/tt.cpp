@@ -0,0 +1,255 @@
+#include "tt.h"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "mapped_file.h"
+
+const char TT_FILE_MAGIC[8] = { 'C', 'H', 'S', 'H', 'A', 'S', 'H', '1' };
+const uint32_t TT_FILE_VERSION = 2; // 2: castling is hashed by rights, so keys of version 1 no longer match
+
+/** Saved table header, followed by `count` TTEntry records **/
+struct TTFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entrySize;  // sizeof(TTEntry) when written, so a layout change is caught
+    uint64_t evalTag;    // Identifies the evaluation; scores from another one are not reused
+    uint64_t count;
+    uint64_t checksum;   // Over the records
+};
+
+/** Relaxed atomics compile to plain loads and stores; the XOR check catches torn slots instead of a lock **/
+struct TTSlot {
+    std::atomic<uint64_t> check;  // key ^ data
+    std::atomic<uint64_t> data;   // score | move << 32 | depth << 48 | bound << 56
+};
+
+static_assert(sizeof(TTSlot) == 16, "slots are two words so shared segments have the same layout everywhere");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared slots must not need a lock");
+static_assert(sizeof(TTEntry) == 16, "saved records are written without padding");
+
+static uint64_t pack_entry(int score, PackedMove move, int depth, Bound bound) {
+    return (uint64_t)(uint32_t)score | (uint64_t)move << 32 | (uint64_t)(uint8_t)depth << 48 | (uint64_t)bound << 56;
+}
+
+static void unpack_entry(uint64_t key, uint64_t data, TTEntry& entry) {
+    entry.key = key;
+    entry.score = (int32_t)(uint32_t)data;
+    entry.move = (PackedMove)(data >> 32);
+    entry.depth = (int8_t)(data >> 48);
+    entry.bound = (uint8_t)(data >> 56);
+}
+
+/** Largest power of two number of slots that fits in the given size **/
+static size_t slots_for(size_t megabytes) {
+    size_t count = 1;
+    while (count * 2 * sizeof(TTSlot) <= megabytes * 1024 * 1024) count *= 2;
+    return count;
+}
+
+/** Tables are large and probed at random, so TLB misses are a real cost; ask for huge pages **/
+static void advise_huge_pages(void* memory, size_t bytes) {
+#ifdef MADV_HUGEPAGE
+    madvise(memory, bytes, MADV_HUGEPAGE);
+#else
+    (void)memory;
+    (void)bytes;
+#endif
+}
+
+/** FNV-1a over 64-bit words; records are whole words, and damage anywhere changes the result **/
+static uint64_t checksum_words(const uint64_t* words, size_t count) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (size_t i = 0; i < count; i++) {
+        hash = (hash ^ words[i]) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+static std::string shared_path(const std::string& name) {
+    return (!name.empty() && name[0] == '/') ? name : "/" + name;
+}
+
+TranspositionTable::TranspositionTable(size_t megabytes) {
+    resize(megabytes);
+}
+
+TranspositionTable::~TranspositionTable() {
+    release();
+}
+
+void TranspositionTable::release() {
+    if (entries) munmap(entries, mappedBytes);
+    entries = nullptr;
+    count = 0;
+    mappedBytes = 0;
+    mask = 0;
+    shared = false;
+}
+
+/** Anonymous mappings are zeroed lazily by the kernel, and zeroed slots are empty **/
+void TranspositionTable::resize(size_t megabytes) {
+    release();
+    size_t slots = slots_for(megabytes);
+    void* memory = mmap(nullptr, slots * sizeof(TTSlot), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) throw std::bad_alloc();
+    advise_huge_pages(memory, slots * sizeof(TTSlot));
+    entries = static_cast<TTSlot*>(memory);
+    count = slots;
+    mappedBytes = slots * sizeof(TTSlot);
+    mask = slots - 1;
+}
+
+bool TranspositionTable::open_shared(const std::string& name, size_t megabytes) {
+    std::string path = shared_path(name);
+    int fd = shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    bool created = fd >= 0;
+    if (!created && errno == EEXIST) fd = shm_open(path.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        std::cout << "Unable to open shared hash " << name << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    if (created && ftruncate(fd, (off_t)(slots_for(megabytes) * sizeof(TTSlot))) != 0) {
+        std::cout << "Unable to size shared hash " << name << ": " << std::strerror(errno) << std::endl;
+        shm_unlink(path.c_str());
+        ::close(fd);
+        return false;
+    }
+
+    // A process that has just created the segment may not have sized it yet
+    struct stat info;
+    for (int attempt = 0; fstat(fd, &info) == 0 && info.st_size == 0 && attempt < 100; attempt++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    size_t bytes = (size_t)info.st_size, slots = bytes / sizeof(TTSlot);
+    if (slots == 0 || (slots & (slots - 1)) != 0 || slots * sizeof(TTSlot) != bytes) {
+        std::cout << "Shared hash " << name << " has an unexpected size of " << bytes << " bytes" << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd); // The mapping keeps the segment alive
+    if (memory == MAP_FAILED) {
+        std::cout << "Unable to map shared hash " << name << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    advise_huge_pages(memory, bytes);
+
+    release();
+    entries = static_cast<TTSlot*>(memory);
+    count = slots;
+    mappedBytes = bytes;
+    mask = slots - 1;
+    shared = true;
+    return true;
+}
+
+bool TranspositionTable::unlink_shared(const std::string& name) {
+    return shm_unlink(shared_path(name).c_str()) == 0;
+}
+
+void TranspositionTable::clear() {
+    std::memset(static_cast<void*>(entries), 0, mappedBytes); // Zeroed slots have BOUND_NONE
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry& entry) const {
+    const TTSlot& slot = entries[key & mask];
+    uint64_t data = slot.data.load(std::memory_order_relaxed);
+    uint64_t check = slot.check.load(std::memory_order_relaxed);
+    if ((check ^ data) != key || (Bound)(data >> 56) == BOUND_NONE) return false;
+    unpack_entry(key, data, entry);
+    return true;
+}
+
+/** Replaces the slot unless it holds a deeper result for the same position **/
+void TranspositionTable::store(uint64_t key, int depth, int score, Bound bound, PackedMove move) {
+    TTSlot& slot = entries[key & mask];
+    uint64_t oldData = slot.data.load(std::memory_order_relaxed);
+    if ((slot.check.load(std::memory_order_relaxed) ^ oldData) == key) {
+        TTEntry old;
+        unpack_entry(key, oldData, old);
+        if (old.depth > depth) return;
+        if (move == NO_MOVE) move = old.move;
+    }
+    uint64_t data = pack_entry(score, move, depth, bound);
+    slot.data.store(data, std::memory_order_relaxed);
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+}
+
+/** Written to a temporary file and renamed into place, so an interrupted save leaves the old file intact **/
+bool TranspositionTable::save(const std::string& path, uint64_t evalTag, int minDepth) const {
+    std::vector<TTEntry> saved;
+    for (size_t i = 0; i < count; i++) {
+        TTEntry entry;
+        uint64_t data = entries[i].data.load(std::memory_order_relaxed);
+        uint64_t key = entries[i].check.load(std::memory_order_relaxed) ^ data;
+        unpack_entry(key, data, entry);
+        if (entry.bound != BOUND_NONE && entry.depth >= minDepth) saved.push_back(entry);
+    }
+
+    TTFileHeader header;
+    std::memcpy(header.magic, TT_FILE_MAGIC, sizeof(header.magic));
+    header.version = TT_FILE_VERSION;
+    header.entrySize = sizeof(TTEntry);
+    header.evalTag = evalTag;
+    header.count = saved.size();
+    header.checksum = checksum_words(reinterpret_cast<const uint64_t*>(saved.data()), saved.size() * sizeof(TTEntry) / 8);
+
+    std::string temporary = path + ".tmp";
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(saved.data()), saved.size() * sizeof(TTEntry));
+    out.close();
+    if (!out || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::cout << "Unable to write " << path << std::endl;
+        std::remove(temporary.c_str());
+        return false;
+    }
+    std::cout << "Saved " << saved.size() << " table entries to " << path << std::endl;
+    return true;
+}
+
+bool TranspositionTable::load(const std::string& path, uint64_t evalTag) {
+    MappedFile file;
+    if (!file.open(path)) return false;
+    TTFileHeader header;
+    if (file.size() < sizeof(header)) {
+        std::cout << path << " is not a saved table" << std::endl;
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    // count comes from the file, so it is bounded before it is multiplied and cannot wrap around
+    if (std::memcmp(header.magic, TT_FILE_MAGIC, sizeof(header.magic)) != 0 || header.version != TT_FILE_VERSION ||
+        header.entrySize != sizeof(TTEntry) || header.count > (file.size() - sizeof(header)) / sizeof(TTEntry) ||
+        file.size() != sizeof(header) + header.count * sizeof(TTEntry)) {
+        std::cout << path << " is not a saved table of this version" << std::endl;
+        return false;
+    }
+    if (header.evalTag != evalTag) {
+        std::cout << path << " was saved with a different evaluation; ignoring it" << std::endl;
+        return false;
+    }
+
+    // The header is a multiple of 8 bytes, so the records are aligned in the mapping
+    const TTEntry* saved = reinterpret_cast<const TTEntry*>(file.data() + sizeof(header));
+    if (checksum_words(reinterpret_cast<const uint64_t*>(saved), header.count * sizeof(TTEntry) / 8) != header.checksum) {
+        std::cout << path << " is damaged (checksum mismatch); ignoring it" << std::endl;
+        return false;
+    }
+    for (uint64_t i = 0; i < header.count; i++) {
+        store(saved[i].key, saved[i].depth, saved[i].score, (Bound)saved[i].bound, saved[i].move);
+    }
+    std::cout << "Loaded " << header.count << " table entries from " << path << std::endl;
+    return true;
+}
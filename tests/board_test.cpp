@@ -0,0 +1,94 @@
+/** Board tests: Zobrist keys depend only on the position, however it was reached **/
+#include <iostream>
+#include <string>
+#include "board.h"
+#include "movegen.h"
+#include "notation.h"
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cout << "FAIL: " << what << std::endl;
+        failures++;
+    }
+}
+
+static bool play(ChessBoard& board, const std::string& moves) {
+    size_t start = 0;
+    while (start < moves.size()) {
+        size_t end = moves.find(' ', start);
+        if (end == std::string::npos) end = moves.size();
+        PackedMove move = parse_uci_move(board, moves.substr(start, end - start));
+        if (move == NO_MOVE) return false;
+        make_move(board, move);
+        start = end + 1;
+    }
+    return true;
+}
+
+static uint64_t fen_hash(const ChessBoard& board) {
+    ChessBoard copy;
+    return copy.load_fen(board.to_fen()) ? copy.hash : 0;
+}
+
+/** Random games from positions with every castling right: each position keeps its key through a FEN round-trip **/
+static void test_fen_round_trip() {
+    const char* starts[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1",
+    };
+    uint64_t seed = 1;
+    int mismatches = 0;
+    for (const char* fen : starts) {
+        for (int game = 0; game < 50; game++) {
+            ChessBoard board;
+            board.load_fen(fen);
+            for (int ply = 0; ply < 80; ply++) {
+                if (board.hash != board.compute_hash() || board.hash != fen_hash(board)) mismatches++;
+                MoveList moves;
+                generate_legal_moves(board, moves);
+                if (moves.size == 0) break;
+                seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+                make_move(board, moves.moves[(seed >> 33) % moves.size]);
+            }
+        }
+    }
+    check(mismatches == 0, "FEN round-trip changed the hash of " + std::to_string(mismatches) + " positions");
+}
+
+/** Pieces that move after castling is already lost change the moved flags but not the position **/
+static void test_castling_shuffle() {
+    ChessBoard board;
+    board.load_fen("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1");
+    check(play(board, "e1f1 e8f8 f1e1 f8e8"), "king moves are legal");
+    ChessBoard loaded;
+    loaded.load_fen("r3k2r/8/8/8/8/8/8/R3K2R w - - 4 3");
+    check(board.hash == loaded.hash, "kings that moved and came back hash like a FEN without castling rights");
+
+    uint64_t before = board.hash;
+    check(play(board, "h1h2 h8h7 h2h1 h7h8"), "rook moves are legal");
+    check(board.hash == before, "rooks that moved and came back keep the hash when no rights are left");
+    check(board.repetition_count() == 1, "the rook shuffle repeats the position");
+}
+
+/** An en passant square is only accepted behind an enemy pawn that could just have made a double push **/
+static void test_en_passant_fen() {
+    ChessBoard board;
+    check(board.load_fen("4k3/8/8/3Pp3/8/8/8/4K3 w - e6 0 1"), "a real en passant square is accepted");
+    check(parse_uci_move(board, "d5e6") != NO_MOVE, "the en passant capture is legal");
+    check(!board.load_fen("4k3/8/8/3Pq3/8/8/8/4K3 w - e6 0 1"), "an en passant square behind a queen is rejected");
+    check(!board.load_fen("4k3/8/8/3PP3/8/8/8/4K3 w - e6 0 1"), "an en passant square behind an own pawn is rejected");
+    check(!board.load_fen("4k3/8/4n3/3Pp3/8/8/8/4K3 w - e6 0 1"), "an occupied en passant square is rejected");
+    check(!board.load_fen("4k3/4n3/8/3Pp3/8/8/8/4K3 w - e6 0 1"), "an occupied pawn start square is rejected");
+    check(!board.load_fen("4k3/8/8/8/3pP3/8/8/4K3 w - e3 0 1"), "a third-rank square with White to move is rejected");
+}
+
+int main() {
+    test_fen_round_trip();
+    test_castling_shuffle();
+    test_en_passant_fen();
+    std::cout << (failures ? "board_test failed" : "board_test passed") << std::endl;
+    return failures ? 1 : 0;
+}
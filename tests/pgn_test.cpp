@@ -0,0 +1,50 @@
+/** PGN importer tests: games are split, replayed and end in the expected positions **/
+#include <iostream>
+#include <string>
+#include <vector>
+#include "board.h"
+#include "pgn.h"
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cout << "FAIL: " << what << std::endl;
+        failures++;
+    }
+}
+
+// The same castling game written with letters, with zeros, and with move numbers glued to the moves
+static const char* PGN_TEXT =
+    "[Event \"Letters\"]\n[Result \"1/2-1/2\"]\n\n"
+    "1. e4 e5 2. Nf3 Nc6 3. Bc4 d6 4. d3 Be6 5. O-O Qd7 6. Nc3 O-O-O 1/2-1/2\n\n"
+    "[Event \"Zeros\"]\n[Result \"1/2-1/2\"]\n\n"
+    "1. e4 e5 2. Nf3 Nc6 3. Bc4 d6 4. d3 Be6 5. 0-0 Qd7 6. Nc3 0-0-0 1/2-1/2\n\n"
+    "[Event \"Glued\"]\n[Result \"1-0\"]\n\n"
+    "1.e4 e5 2.Nf3 Nc6 3.Bc4 d6 4.d3 Be6 5.0-0 Qd7 6.Nc3 6...0-0-0 1-0\n";
+
+static const char* FINAL_FEN = "2kr1bnr/pppq1ppp/2npb3/4p3/2B1P3/2NP1N2/PPP2PPP/R1BQ1RK1 w - - 4 7";
+
+int main() {
+    std::string text = PGN_TEXT;
+    std::vector<PgnGameSpan> spans;
+    scan_pgn_games(text.data(), text.size(), spans);
+    check(spans.size() == 3, "three games are found, not " + std::to_string(spans.size()));
+
+    ChessBoard expected;
+    expected.load_fen(FINAL_FEN);
+    for (size_t i = 0; i < spans.size(); i++) {
+        std::string game = "game " + std::to_string(i + 1);
+        ChessBoard board;
+        PgnGameInfo info;
+        std::vector<uint64_t> hashes;
+        bool ok = replay_pgn_game(std::string_view(text).substr(spans[i].offset, spans[i].length), board, info, &hashes);
+        check(ok && info.ok, game + " replays (error at \"" + info.error + "\")");
+        check(info.plies == 12, game + " has 12 plies, not " + std::to_string(info.plies));
+        check(hashes.size() == 13, game + " records a hash per position");
+        check(board.hash == expected.hash, game + " ends with both sides castled");
+        check(info.result == (i < 2 ? RESULT_DRAW : RESULT_WHITE_WINS), game + " has its result");
+    }
+    std::cout << (failures ? "pgn_test failed" : "pgn_test passed") << std::endl;
+    return failures ? 1 : 0;
+}
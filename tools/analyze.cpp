@@ -0,0 +1,186 @@
+/** Streaming batch analyzer: best move and score for every FEN/EPD line of a file **/
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include "ai.h"
+#include "board.h"
+#include "notation.h"
+#include "thread_pool.h"
+#include "trace.h"
+
+struct Options {
+    SearchLimits limits;
+    int threads = ThreadPool::default_threads();
+    int window = 0;          // Positions in flight at once; 0 picks a multiple of the thread count
+    std::string inputFile;   // Empty for stdin
+    std::string outputFile;  // Empty for stdout
+    std::string traceFile;   // Search events of every position, for tracedump
+};
+
+static void print_usage() {
+    std::cout << "usage: analyze [options] [input.epd]\n"
+              << "  -depth N        search depth per position (default " << SEARCH_DEPTH << ")\n"
+              << "  -nodes N        node limit per position\n"
+              << "  -movetime MS    time limit per position in milliseconds\n"
+              << "  -threads N      positions analyzed in parallel (default: all cores)\n"
+              << "  -window N       maximum positions read ahead of the output (bounds memory)\n"
+              << "  -o FILE         write results to FILE instead of stdout\n"
+              << "  -trace FILE     record every search's tree events to FILE (see tracedump)\n"
+              << "Reads FEN or EPD lines from the input (stdin if omitted) and writes one EPD line per\n"
+              << "position with bm (best move), ce (centipawns), acd (depth) and acn (nodes), in input order;\n"
+              << "forced mates add dm (moves to mate) and pv (the mating line).\n";
+}
+
+static bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-depth" && hasValue) options.limits.depth = std::atoi(argv[++i]);
+        else if (arg == "-nodes" && hasValue) options.limits.nodes = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "-movetime" && hasValue) options.limits.moveTimeMs = std::atoi(argv[++i]);
+        else if (arg == "-threads" && hasValue) options.threads = std::atoi(argv[++i]);
+        else if (arg == "-window" && hasValue) options.window = std::atoi(argv[++i]);
+        else if (arg == "-o" && hasValue) options.outputFile = argv[++i];
+        else if (arg == "-trace" && hasValue) options.traceFile = argv[++i];
+        else if (arg[0] != '-' && options.inputFile.empty()) options.inputFile = arg;
+        else return false;
+    }
+    if (options.threads < 1) options.threads = 1;
+    if (options.window <= 0) options.window = 4 * options.threads;
+    return true;
+}
+
+/** Splits an EPD/FEN line into the position part and any trailing EPD operations **/
+static void split_epd(const std::string& line, std::string& fen, std::string& operations) {
+    std::istringstream stream(line);
+    std::string field;
+    fen.clear();
+    for (int i = 0; i < 4 && stream >> field; i++) {
+        fen += (i ? " " : "") + field;
+    }
+    // Optional FEN move counters
+    std::streampos afterFields = stream.tellg();
+    std::string halfmoves, fullmoves;
+    if (stream >> halfmoves >> fullmoves &&
+        halfmoves.find_first_not_of("0123456789") == std::string::npos &&
+        fullmoves.find_first_not_of("0123456789") == std::string::npos) {
+        fen += " " + halfmoves + " " + fullmoves;
+        afterFields = stream.tellg();
+    }
+    std::string rest = (afterFields == std::streampos(-1)) ? "" : line.substr((size_t)afterFields);
+
+    // Keep the input's operations except the ones this tool writes itself
+    std::istringstream opStream(rest);
+    std::string op;
+    operations.clear();
+    while (std::getline(opStream, op, ';')) {
+        size_t start = op.find_first_not_of(' ');
+        if (start == std::string::npos) continue;
+        op = op.substr(start);
+        std::string opcode = op.substr(0, op.find(' '));
+        if (opcode != "bm" && opcode != "ce" && opcode != "acd" && opcode != "acn" && opcode != "dm" && opcode != "pv") {
+            operations += (operations.empty() ? "" : " ") + op + ";";
+        }
+    }
+}
+
+static std::string analyze_line(const std::string& line, const SearchLimits& limits, SearchResult& result) {
+    std::string fen, operations;
+    split_epd(line, fen, operations);
+
+    ChessBoard board;
+    if (!board.load_fen(fen)) {
+        return line + (line.empty() ? "" : " ") + "error \"invalid position\";";
+    }
+
+    result = search_best_move(board, limits);
+    std::ostringstream out;
+    out << fen << " bm " << (result.bestMove == NO_MOVE ? "none" : move_to_san(board, result.bestMove))
+        << "; ce " << result.score << "; acd " << result.depth << "; acn " << result.nodes << ";";
+    if (is_mate_score(result.score) && result.score > 0) out << " dm " << mate_in_moves(result.score) << ";";
+    if (!result.mateLine.empty()) out << " pv " << line_to_san(board, result.mateLine) << ";";
+    if (!operations.empty()) out << " " << operations;
+    return out.str();
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage();
+        return 1;
+    }
+
+    std::ifstream inputFile;
+    std::ofstream outputFile;
+    if (!options.inputFile.empty()) {
+        inputFile.open(options.inputFile);
+        if (!inputFile) {
+            std::cerr << "Unable to open " << options.inputFile << std::endl;
+            return 1;
+        }
+    }
+    if (!options.outputFile.empty()) {
+        outputFile.open(options.outputFile);
+        if (!outputFile) {
+            std::cerr << "Unable to open " << options.outputFile << " for writing" << std::endl;
+            return 1;
+        }
+    }
+    if (!options.traceFile.empty() && !trace_start(options.traceFile)) return 1;
+    std::istream& input = options.inputFile.empty() ? std::cin : inputFile;
+    std::ostream& output = options.outputFile.empty() ? std::cout : outputFile;
+
+    // Finished results wait here until every earlier line has been written. The reader stops once
+    // `window` positions are outstanding, so memory stays bounded however large the input is.
+    std::mutex mutex;
+    std::condition_variable windowOpen;
+    std::map<uint64_t, std::string> finished;
+    uint64_t nextToWrite = 0, totalNodes = 0;
+    EvalStats totalEval;
+
+    auto startTime = std::chrono::steady_clock::now();
+    uint64_t positions = 0;
+    {
+        ThreadPool pool(options.threads);
+        std::string line;
+        while (std::getline(input, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            uint64_t index = positions++;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                windowOpen.wait(lock, [&] { return index - nextToWrite < (uint64_t)options.window; });
+            }
+            pool.submit([&, index, line] {
+                SearchResult search;
+                std::string result = analyze_line(line, options.limits, search);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                totalNodes += search.nodes;
+                totalEval += search.evalStats;
+                finished[index] = result;
+                while (!finished.empty() && finished.begin()->first == nextToWrite) {
+                    output << finished.begin()->second << '\n';
+                    finished.erase(finished.begin());
+                    nextToWrite++;
+                }
+                windowOpen.notify_one();
+            });
+        }
+        pool.wait();
+    }
+    output.flush();
+    trace_stop();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    std::cerr << positions << " positions in " << seconds << " s: " << (uint64_t)(seconds > 0 ? positions / seconds : 0)
+              << " positions/s, " << (uint64_t)(seconds > 0 ? totalNodes / seconds : 0) << " nodes/s on "
+              << options.threads << " threads; eval cache hits " << (int)(100 * totalEval.eval_hit_rate())
+              << "%, pawn cache hits " << (int)(100 * totalEval.pawn_hit_rate()) << "%" << std::endl;
+    return 0;
+}
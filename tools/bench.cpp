@@ -0,0 +1,109 @@
+/** Deterministic benchmark: fixed positions searched to a fixed depth, with the total node count as a signature **/
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "ai.h"
+#include "board.h"
+#include "nnue.h"
+#include "notation.h"
+#include "tt.h"
+
+const int BENCH_DEFAULT_DEPTH = 6;
+const size_t BENCH_DEFAULT_HASH_MB = 16;
+
+// Openings, middlegames and endgames, with castling, en passant and promotions on the board
+static const char* BENCH_POSITIONS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+    "r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15",
+    "r1bbk1nr/pp3p1p/2n5/1N4p1/2Np1B2/8/PPP2PPP/2KR1B1R w kq - 0 13",
+    "r1bq1rk1/ppp1nppp/4n3/3p3Q/3P4/1BP1B3/PP1N2PP/R4RK1 w - - 1 16",
+    "4r1k1/r1q2ppp/ppp2n2/4P3/5Rb1/1N1BQ3/PPP3PP/R5K1 w - - 1 17",
+    "2rqkb1r/ppp2p2/2npb1p1/1N1Nn2p/2P1PP2/8/PP2B1PP/R1BQK2R b KQ - 0 11",
+    "6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/3N4 b - - 0 1",
+    "3b4/5kp1/1p1p1p1p/pP1PpP1P/P1P1P3/3KN3/8/8 w - - 0 1",
+    "8/8/8/8/5kp1/P7/8/1K1N4 w - - 0 1",
+    "8/8/1P6/5pr1/8/4R3/7k/2K5 w - - 0 1",
+};
+
+struct Options {
+    int depth = BENCH_DEFAULT_DEPTH;
+    size_t hashMb = BENCH_DEFAULT_HASH_MB;
+    std::string nnueFile;
+    bool verbose = false;
+};
+
+static void print_usage() {
+    std::cout << "usage: bench [options]\n"
+              << "  -depth N      search depth per position (default " << BENCH_DEFAULT_DEPTH << ")\n"
+              << "  -hash MB      transposition table size (default " << BENCH_DEFAULT_HASH_MB << ")\n"
+              << "  -nnue FILE    evaluate with a network instead of the material evaluation\n"
+              << "  -v            print each position's move, score and nodes\n"
+              << "Searches a fixed set of positions on one thread with the game's search and prints the\n"
+              << "total node count, which only changes when the search itself does, with the speed.\n";
+}
+
+static bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-depth" && hasValue) options.depth = std::atoi(argv[++i]);
+        else if (arg == "-hash" && hasValue) options.hashMb = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "-nnue" && hasValue) options.nnueFile = argv[++i];
+        else if (arg == "-v") options.verbose = true;
+        else return false;
+    }
+    return options.depth > 0 && options.depth <= MAX_SEARCH_DEPTH && options.hashMb > 0;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage();
+        return 1;
+    }
+    if (!options.nnueFile.empty() && !nnue_load(options.nnueFile)) return 1;
+
+    // The limits make_best_move uses at the default strength, with the depth fixed and no clock involved
+    SearchLimits limits = strength_limits(DEFAULT_STRENGTH_LEVEL);
+    limits.depth = options.depth;
+    limits.nodes = 0;
+    limits.moveTimeMs = 0;
+
+    TranspositionTable table(options.hashMb);
+    uint64_t totalNodes = 0;
+    double totalSeconds = 0;
+    int positions = 0;
+    for (const char* fen : BENCH_POSITIONS) {
+        ChessBoard board;
+        if (!board.load_fen(fen)) {
+            std::cout << "Invalid bench position " << fen << std::endl;
+            return 1;
+        }
+        // Every position starts from an empty table, so its count does not depend on the others
+        table.clear();
+        auto start = std::chrono::steady_clock::now();
+        SearchResult result = search_best_move(board, limits, &table);
+        totalSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        totalNodes += result.nodes;
+        positions++;
+        if (options.verbose) {
+            std::cout << "Position " << positions << ": " << move_to_uci(result.bestMove) << " score " << result.score
+                      << " nodes " << result.nodes << std::endl;
+        }
+    }
+
+    std::cout << "Evaluation: " << (nnue_enabled() ? "network " + options.nnueFile : std::string("material")) << "\n"
+              << "Positions:  " << positions << " at depth " << options.depth << "\n"
+              << "Time:       " << (int)(1000 * totalSeconds) << " ms\n"
+              << "Nodes/s:    " << (uint64_t)(totalNodes / std::max(totalSeconds, 1e-9)) << "\n"
+              << "Nodes:      " << totalNodes << std::endl;
+    return 0;
+}
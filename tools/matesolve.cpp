@@ -0,0 +1,96 @@
+/** Forced-mate solver: proof-number search on every FEN/EPD line of a file **/
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "board.h"
+#include "notation.h"
+#include "pns.h"
+
+struct Options {
+    MateSolverOptions solver;
+    std::string inputFile;   // Empty for stdin
+};
+
+static void print_usage() {
+    std::cout << "usage: matesolve [options] [input.epd]\n"
+              << "  -nodes N        positions expanded per problem (default " << PNS_DEFAULT_NODES << ")\n"
+              << "  -hash MB        solver table size in megabytes (default " << PNS_DEFAULT_MB << ")\n"
+              << "  -checks         only consider checking moves for the mating side\n"
+              << "Reads FEN or EPD lines from the input (stdin if omitted) and writes, for the side to move,\n"
+              << "dm (moves to mate) and pv (the mating line), or a comment when no mate was found.\n";
+}
+
+static bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-nodes" && hasValue) options.solver.nodes = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "-hash" && hasValue) options.solver.hashMb = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "-checks") options.solver.checksOnly = true;
+        else if (arg[0] != '-' && options.inputFile.empty()) options.inputFile = arg;
+        else return false;
+    }
+    return options.solver.nodes > 0;
+}
+
+/** The position fields of a FEN or EPD line, with the move counters if present **/
+static std::string position_fields(const std::string& line) {
+    std::istringstream stream(line);
+    std::string field, fen;
+    for (int i = 0; i < 6 && stream >> field; i++) {
+        if (i >= 4 && field.find_first_not_of("0123456789") != std::string::npos) break;
+        fen += (i ? " " : "") + field;
+    }
+    return fen;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage();
+        return 1;
+    }
+
+    std::ifstream inputFile;
+    if (!options.inputFile.empty()) {
+        inputFile.open(options.inputFile);
+        if (!inputFile) {
+            std::cerr << "Unable to open " << options.inputFile << std::endl;
+            return 1;
+        }
+    }
+    std::istream& input = options.inputFile.empty() ? std::cin : inputFile;
+
+    uint64_t positions = 0, proven = 0, totalNodes = 0;
+    auto startTime = std::chrono::steady_clock::now();
+    std::string line;
+    while (std::getline(input, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        positions++;
+        std::string fen = position_fields(line);
+        ChessBoard board;
+        if (!board.load_fen(fen)) {
+            std::cout << line << " error \"invalid position\";" << std::endl;
+            continue;
+        }
+
+        MateResult result = solve_mate(board, options.solver);
+        totalNodes += result.nodes;
+        std::cout << fen;
+        if (result.status == MATE_PROVEN) {
+            proven++;
+            std::cout << " dm " << result.mateIn << "; pv " << line_to_san(board, result.line) << ";";
+        } else {
+            std::cout << " c0 \"" << (result.status == MATE_DISPROVEN ? "no forced mate" : "node limit reached") << "\";";
+        }
+        std::cout << " acn " << result.nodes << ";" << std::endl;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    std::cerr << proven << " of " << positions << " mates found in " << seconds << " s, "
+              << (uint64_t)(seconds > 0 ? totalNodes / seconds : 0) << " nodes/s" << std::endl;
+    return 0;
+}
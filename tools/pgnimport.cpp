@@ -0,0 +1,149 @@
+/** PGN importer: replays every game of a (possibly huge) PGN file and writes a game index **/
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "board.h"
+#include "mapped_file.h"
+#include "pgn.h"
+#include "thread_pool.h"
+
+struct Options {
+    int threads = ThreadPool::default_threads();
+    int batch = 256;             // Games per task
+    int window = 0;              // Batches in flight at once; 0 picks a multiple of the thread count
+    int maxErrors = 10;          // Parse errors reported individually
+    std::string inputFile;
+    std::string indexFile;       // Empty to only parse
+};
+
+/** Results of one batch, kept until every earlier batch has been written **/
+struct BatchResult {
+    std::vector<PgnGameInfo> games;
+    std::vector<size_t> hashCounts;
+    std::vector<uint64_t> hashes;
+};
+
+static void print_usage() {
+    std::cout << "usage: pgnimport [options] games.pgn\n"
+              << "  -index FILE     write the game index (offsets, results and position hashes) to FILE\n"
+              << "  -threads N      games parsed in parallel (default: all cores; 1 for a sequential import)\n"
+              << "  -batch N        games per task (default 256)\n"
+              << "  -window N       maximum batches parsed ahead of the index writer (bounds memory)\n"
+              << "  -errors N       parse errors to report individually (default 10)\n";
+}
+
+static bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-index" && hasValue) options.indexFile = argv[++i];
+        else if (arg == "-threads" && hasValue) options.threads = std::atoi(argv[++i]);
+        else if (arg == "-batch" && hasValue) options.batch = std::atoi(argv[++i]);
+        else if (arg == "-window" && hasValue) options.window = std::atoi(argv[++i]);
+        else if (arg == "-errors" && hasValue) options.maxErrors = std::atoi(argv[++i]);
+        else if (arg[0] != '-' && options.inputFile.empty()) options.inputFile = arg;
+        else return false;
+    }
+    if (options.inputFile.empty()) return false;
+    if (options.threads < 1) options.threads = 1;
+    if (options.batch < 1) options.batch = 1;
+    if (options.window <= 0) options.window = 4 * options.threads;
+    return true;
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage();
+        return 1;
+    }
+
+    MappedFile pgn;
+    if (!pgn.open(options.inputFile)) return 1;
+
+    auto startTime = std::chrono::steady_clock::now();
+    std::vector<PgnGameSpan> spans;
+    scan_pgn_games(pgn.data(), pgn.size(), spans);
+    double scanSeconds = seconds_since(startTime);
+
+    PgnIndexWriter writer;
+    bool writeIndex = !options.indexFile.empty();
+    if (writeIndex && !writer.open(options.indexFile, spans.size())) return 1;
+
+    std::mutex mutex;
+    std::condition_variable windowOpen;
+    std::map<size_t, BatchResult> finished;
+    size_t nextToWrite = 0;
+    uint64_t totalPlies = 0, errors = 0;
+
+    size_t batchCount = (spans.size() + options.batch - 1) / options.batch;
+    {
+        ThreadPool pool(options.threads);
+        for (size_t batch = 0; batch < batchCount; batch++) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                windowOpen.wait(lock, [&] { return batch - nextToWrite < (size_t)options.window; });
+            }
+            pool.submit([&, batch] {
+                size_t first = batch * options.batch;
+                size_t last = std::min(spans.size(), first + options.batch);
+                BatchResult result;
+                ChessBoard board;
+                uint64_t plies = 0;
+                for (size_t i = first; i < last; i++) {
+                    PgnGameInfo info;
+                    size_t before = result.hashes.size();
+                    std::string_view text(pgn.data() + spans[i].offset, spans[i].length);
+                    replay_pgn_game(text, board, info, writeIndex ? &result.hashes : nullptr);
+                    plies += info.plies;
+                    result.hashCounts.push_back(result.hashes.size() - before);
+                    result.games.push_back(std::move(info));
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                totalPlies += plies;
+                for (size_t i = first; i < last; i++) {
+                    const PgnGameInfo& info = result.games[i - first];
+                    if (!info.ok && errors++ < (uint64_t)options.maxErrors) {
+                        std::cerr << "Game " << i + 1 << " (byte " << spans[i].offset << "): cannot parse \""
+                                  << info.error << "\" after " << info.plies << " plies" << std::endl;
+                    }
+                }
+                finished[batch] = std::move(result);
+                while (!finished.empty() && finished.begin()->first == nextToWrite) {
+                    if (writeIndex) {
+                        const BatchResult& done = finished.begin()->second;
+                        const uint64_t* hashes = done.hashes.data();
+                        for (size_t i = 0; i < done.games.size(); i++) {
+                            writer.add(spans[nextToWrite * options.batch + i], done.games[i], hashes, done.hashCounts[i]);
+                            hashes += done.hashCounts[i];
+                        }
+                    }
+                    finished.erase(finished.begin());
+                    nextToWrite++;
+                }
+                windowOpen.notify_one();
+            });
+        }
+        pool.wait();
+    }
+    if (writeIndex && !writer.finish()) return 1;
+
+    double seconds = seconds_since(startTime);
+    double megabytes = pgn.size() / (1024.0 * 1024.0);
+    std::cout << spans.size() << " games, " << totalPlies << " plies, " << errors << " with errors\n"
+              << "scan " << scanSeconds << " s, total " << seconds << " s on " << options.threads << " threads\n"
+              << (uint64_t)(seconds > 0 ? spans.size() / seconds : 0) << " games/s, "
+              << (uint64_t)(seconds > 0 ? totalPlies / seconds : 0) << " plies/s, "
+              << (seconds > 0 ? megabytes / seconds : 0) << " MB/s" << std::endl;
+    return 0;
+}
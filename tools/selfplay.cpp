@@ -0,0 +1,439 @@
+/** Headless self-play tournament between two engine configurations **/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ai.h"
+#include "board.h"
+#include "mcts.h"
+#include "notation.h"
+#include "thread_pool.h"
+
+struct EngineConfig {
+    std::string name;
+    SearchLimits limits;
+    Engine engine = ENGINE_ALPHA_BETA;
+    MctsOptions mcts;
+    size_t hashMb = 0;            // Transposition table per game; 0 for none
+    std::string sharedHash;       // Named shared-memory table used by every game, and other processes
+    std::shared_ptr<TranspositionTable> sharedTable;
+};
+
+struct Options {
+    EngineConfig engines[2];
+    int games = 100;
+    int concurrency = ThreadPool::default_threads();
+    std::string openingsFile;
+    std::string pgnFile;
+    int maxPlies = 400;
+    int resignScore = 0;     // Centipawns; 0 disables resign adjudication
+    int resignMoves = 4;
+    int drawScore = 0;       // Centipawns; 0 disables draw adjudication
+    int drawMoves = 8;
+    int drawMinPly = 60;
+    bool sprt = false;
+    double elo0 = 0, elo1 = 5, alpha = 0.05, beta = 0.05;
+};
+
+struct Opening {
+    std::string fen;                 // Empty for the standard starting position
+    std::vector<PackedMove> moves;
+};
+
+struct GameRecord {
+    int round = 0;
+    int whiteEngine = 0;
+    std::string startFen;
+    std::string result;      // "1-0", "0-1" or "1/2-1/2"
+    std::string termination;
+    std::vector<std::string> movetext; // SAN moves, numbered where PGN requires it
+};
+
+// Used when no openings file is given, so that paired games do not all repeat the same line
+static const char* DEFAULT_OPENINGS[] = {
+    "e2e4 e7e5 g1f3 b8c6", "e2e4 c7c5 g1f3 d7d6", "e2e4 e7e6 d2d4 d7d5", "e2e4 c7c6 d2d4 d7d5",
+    "d2d4 d7d5 c2c4 e7e6", "d2d4 g8f6 c2c4 g7g6", "d2d4 g8f6 c2c4 e7e6", "c2c4 e7e5 b1c3 g8f6",
+    "g1f3 d7d5 g2g3 g8f6", "e2e4 e7e5 f1c4 g8f6", "d2d4 d7d5 g1f3 g8f6", "e2e4 d7d5 e4d5 d8d5",
+};
+
+static void print_usage() {
+    std::cout << "usage: selfplay [options]\n"
+              << "  -a SPEC, -b SPEC        engine configurations, e.g. name=new,depth=5,nodes=20000,movetime=100\n"
+              << "                          or name=mc,engine=mcts,movetime=100,threads=2,playout=0,tree=1000000\n"
+              << "                          alpha-beta engines take hash=MB and shm=NAME for a shared-memory table\n"
+              << "                          level=N (1-8) uses a strength level's budgets and noise; keys after it override\n"
+              << "  -games N                number of games (default 100)\n"
+              << "  -concurrency N          games played in parallel (default: all cores)\n"
+              << "  -openings FILE          one opening per line: coordinate moves (e2e4 e7e5 ...) or a FEN\n"
+              << "  -pgn FILE               write every game to a PGN file\n"
+              << "  -maxplies N             adjudicate a draw after N plies (default 400)\n"
+              << "  -resign CP MOVES        adjudicate a loss after MOVES moves scored below -CP\n"
+              << "  -draw CP MOVES PLY      adjudicate a draw after MOVES moves per side within CP, from ply PLY\n"
+              << "  -sprt ELO0 ELO1 [ALPHA BETA]  stop as soon as the SPRT accepts a hypothesis\n";
+}
+
+/** Parses a comma-separated key=value engine specification **/
+static bool parse_engine(const std::string& spec, EngineConfig& config) {
+    std::stringstream stream(spec);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        size_t equals = item.find('=');
+        if (equals == std::string::npos) return false;
+        std::string key = item.substr(0, equals), value = item.substr(equals + 1);
+        if (key == "name") config.name = value;
+        else if (key == "level") config.limits = strength_limits(std::atoi(value.c_str()));
+        else if (key == "depth") config.limits.depth = std::atoi(value.c_str());
+        else if (key == "nodes") config.limits.nodes = std::strtoull(value.c_str(), nullptr, 10);
+        else if (key == "movetime") config.limits.moveTimeMs = std::atoi(value.c_str());
+        else if (key == "engine" && (value == "mcts" || value == "alphabeta")) config.engine = (value == "mcts") ? ENGINE_MCTS : ENGINE_ALPHA_BETA;
+        else if (key == "threads") config.mcts.threads = std::max(1, std::atoi(value.c_str()));
+        else if (key == "playout") config.mcts.playoutPlies = std::atoi(value.c_str());
+        else if (key == "tree") config.mcts.maxNodes = std::strtoull(value.c_str(), nullptr, 10);
+        else if (key == "hash") config.hashMb = std::strtoull(value.c_str(), nullptr, 10);
+        else if (key == "shm") config.sharedHash = value;
+        else return false;
+    }
+    return true;
+}
+
+static bool parse_options(int argc, char* argv[], Options& options) {
+    options.engines[0].name = "A";
+    options.engines[1].name = "B";
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        int remaining = argc - i - 1;
+        if ((arg == "-a" || arg == "-b") && remaining >= 1) {
+            if (!parse_engine(argv[++i], options.engines[arg == "-a" ? 0 : 1])) return false;
+        } else if (arg == "-games" && remaining >= 1) {
+            options.games = std::atoi(argv[++i]);
+        } else if (arg == "-concurrency" && remaining >= 1) {
+            options.concurrency = std::atoi(argv[++i]);
+        } else if (arg == "-openings" && remaining >= 1) {
+            options.openingsFile = argv[++i];
+        } else if (arg == "-pgn" && remaining >= 1) {
+            options.pgnFile = argv[++i];
+        } else if (arg == "-maxplies" && remaining >= 1) {
+            options.maxPlies = std::atoi(argv[++i]);
+        } else if (arg == "-resign" && remaining >= 2) {
+            options.resignScore = std::atoi(argv[++i]);
+            options.resignMoves = std::atoi(argv[++i]);
+        } else if (arg == "-draw" && remaining >= 3) {
+            options.drawScore = std::atoi(argv[++i]);
+            options.drawMoves = std::atoi(argv[++i]);
+            options.drawMinPly = std::atoi(argv[++i]);
+        } else if (arg == "-sprt" && remaining >= 2) {
+            options.sprt = true;
+            options.elo0 = std::atof(argv[++i]);
+            options.elo1 = std::atof(argv[++i]);
+            if (remaining >= 4 && argv[i + 1][0] != '-') {
+                options.alpha = std::atof(argv[++i]);
+                options.beta = std::atof(argv[++i]);
+            }
+        } else {
+            return false;
+        }
+    }
+    return options.games > 0;
+}
+
+/** Reads openings as FEN positions or lists of coordinate moves, checking moves against the move generator **/
+static bool load_openings(const Options& options, std::vector<Opening>& openings) {
+    std::vector<std::string> lines;
+    if (options.openingsFile.empty()) {
+        lines.assign(std::begin(DEFAULT_OPENINGS), std::end(DEFAULT_OPENINGS));
+    } else {
+        std::ifstream file(options.openingsFile);
+        if (!file) {
+            std::cout << "Unable to open openings file " << options.openingsFile << std::endl;
+            return false;
+        }
+        std::string line;
+        while (std::getline(file, line)) {
+            if (!line.empty() && line[0] != '#') lines.push_back(line);
+        }
+    }
+
+    for (const std::string& line : lines) {
+        Opening opening;
+        ChessBoard board;
+        if (line.find('/') != std::string::npos) {
+            if (!board.load_fen(line)) {
+                std::cout << "Invalid FEN in openings: " << line << std::endl;
+                return false;
+            }
+            opening.fen = board.to_fen();
+            openings.push_back(opening);
+            continue;
+        }
+        std::stringstream stream(line);
+        std::string text;
+        while (stream >> text) {
+            PackedMove move = parse_uci_move(board, text);
+            if (move == NO_MOVE) {
+                std::cout << "Illegal move " << text << " in opening: " << line << std::endl;
+                return false;
+            }
+            make_move(board, move);
+            opening.moves.push_back(move);
+        }
+        openings.push_back(opening);
+    }
+    return !openings.empty();
+}
+
+/** Appends a move in SAN with its move number (always for White, for Black only at the start) **/
+static void record_move(GameRecord& game, ChessBoard& board, PackedMove move) {
+    std::string san = move_to_san(board, move);
+    if (board.sideToMove == WHITE) {
+        san = std::to_string(board.fullmoveNumber) + ". " + san;
+    } else if (game.movetext.empty()) {
+        san = std::to_string(board.fullmoveNumber) + "... " + san;
+    }
+    game.movetext.push_back(san);
+    make_move(board, move);
+}
+
+static GameRecord play_game(const Options& options, const Opening& opening, int whiteEngine, int round) {
+    GameRecord game;
+    game.round = round;
+    game.whiteEngine = whiteEngine;
+    game.startFen = opening.fen;
+
+    ChessBoard board;
+    if (!opening.fen.empty()) {
+        board.load_fen(opening.fen);
+    }
+    for (PackedMove move : opening.moves) {
+        record_move(game, board, move);
+    }
+
+    // MCTS engines keep their tree for the whole game so each search can reuse the last one
+    std::unique_ptr<MctsTree> trees[2];
+    for (int engine = 0; engine < 2; engine++) {
+        if (options.engines[engine].engine == ENGINE_MCTS) {
+            trees[engine].reset(new MctsTree(options.engines[engine].mcts.maxNodes));
+        }
+    }
+
+    // Alpha-beta engines with a hash keep their table for the game; a shared table spans all games
+    std::unique_ptr<TranspositionTable> tables[2];
+    TranspositionTable* tt[2] = { nullptr, nullptr };
+    for (int engine = 0; engine < 2; engine++) {
+        const EngineConfig& config = options.engines[engine];
+        if (config.sharedTable) {
+            tt[engine] = config.sharedTable.get();
+        } else if (config.hashMb > 0) {
+            tables[engine].reset(new TranspositionTable(config.hashMb));
+            tt[engine] = tables[engine].get();
+        }
+    }
+
+    int lowScoreMoves[2] = { 0, 0 };
+    int drawishPlies = 0;
+    while (true) {
+        Color mover = board.sideToMove;
+        const char* moverLoses = (mover == WHITE) ? "0-1" : "1-0";
+        MoveList moves;
+        generate_legal_moves(board, moves);
+        if (moves.empty()) {
+            bool mate = is_check(board, mover);
+            game.result = mate ? moverLoses : "1/2-1/2";
+            game.termination = mate ? "checkmate" : "stalemate";
+            break;
+        }
+        if (board.repetition_count() >= 2 || board.is_fifty_move_draw() || has_insufficient_material(board) ||
+            (int)board.moveHistory.size() >= options.maxPlies) {
+            game.result = "1/2-1/2";
+            game.termination = board.repetition_count() >= 2 ? "threefold repetition"
+                             : board.is_fifty_move_draw() ? "fifty-move rule"
+                             : has_insufficient_material(board) ? "insufficient material" : "move limit";
+            break;
+        }
+
+        int engine = (mover == WHITE) ? whiteEngine : 1 - whiteEngine;
+        const EngineConfig& config = options.engines[engine];
+        SearchLimits limits = config.limits;
+        limits.noiseSeed = board.hash ^ ((uint64_t)game.round << 32); // Reproducible, but different in every game
+        SearchResult search = (config.engine == ENGINE_MCTS) ? mcts_search(board, limits, *trees[engine], config.mcts)
+                                                             : search_best_move(board, limits, tt[engine]);
+
+        // Adjudication uses the score reported by the engine to move
+        if (options.resignScore > 0) {
+            lowScoreMoves[engine] = (search.score <= -options.resignScore) ? lowScoreMoves[engine] + 1 : 0;
+            if (lowScoreMoves[engine] >= options.resignMoves) {
+                game.result = moverLoses;
+                game.termination = "adjudicated loss";
+                break;
+            }
+        }
+        if (options.drawScore > 0) {
+            bool drawish = (int)board.moveHistory.size() >= options.drawMinPly && std::abs(search.score) <= options.drawScore;
+            drawishPlies = drawish ? drawishPlies + 1 : 0;
+            if (drawishPlies >= 2 * options.drawMoves) {
+                game.result = "1/2-1/2";
+                game.termination = "adjudicated draw";
+                break;
+            }
+        }
+
+        record_move(game, board, search.bestMove);
+    }
+    return game;
+}
+
+static std::string pgn_date() {
+    char buffer[16];
+    std::time_t now = std::time(nullptr);
+    std::strftime(buffer, sizeof(buffer), "%Y.%m.%d", std::localtime(&now));
+    return buffer;
+}
+
+static void write_pgn(std::ostream& out, const Options& options, const GameRecord& game, const std::string& date) {
+    out << "[Event \"Self-play\"]\n"
+        << "[Site \"?\"]\n"
+        << "[Date \"" << date << "\"]\n"
+        << "[Round \"" << game.round << "\"]\n"
+        << "[White \"" << options.engines[game.whiteEngine].name << "\"]\n"
+        << "[Black \"" << options.engines[1 - game.whiteEngine].name << "\"]\n"
+        << "[Result \"" << game.result << "\"]\n"
+        << "[Termination \"" << game.termination << "\"]\n";
+    if (!game.startFen.empty()) {
+        out << "[SetUp \"1\"]\n"
+            << "[FEN \"" << game.startFen << "\"]\n";
+    }
+    out << "[PlyCount \"" << game.movetext.size() << "\"]\n\n";
+
+    std::string line;
+    for (const std::string& token : game.movetext) {
+        if (line.size() + token.size() + 1 > 79) {
+            out << line << "\n";
+            line.clear();
+        }
+        line += line.empty() ? token : " " + token;
+    }
+    out << line << (line.empty() ? "" : " ") << game.result << "\n\n";
+}
+
+static double elo_from_score(double score) {
+    score = std::min(std::max(score, 1e-6), 1 - 1e-6);
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+static double score_from_elo(double elo) {
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+struct Tally {
+    int wins = 0, draws = 0, losses = 0; // From engine A's point of view
+
+    int games() const { return wins + draws + losses; }
+    double score() const { return (wins + 0.5 * draws) / games(); }
+    double variance() const {
+        double s = score();
+        return (wins * (1 - s) * (1 - s) + draws * (0.5 - s) * (0.5 - s) + losses * s * s) / games();
+    }
+
+    // Log-likelihood ratio of H1 (elo1) against H0 (elo0), normal approximation of the generalized SPRT
+    double llr(double elo0, double elo1) const {
+        if (games() == 0 || variance() <= 0) return 0;
+        double s0 = score_from_elo(elo0), s1 = score_from_elo(elo1);
+        return games() * (s1 - s0) * (2 * score() - s0 - s1) / (2 * variance());
+    }
+};
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage();
+        return 1;
+    }
+    std::vector<Opening> openings;
+    if (!load_openings(options, openings)) {
+        return 1;
+    }
+
+    for (EngineConfig& config : options.engines) {
+        if (config.sharedHash.empty()) continue;
+        config.sharedTable = std::make_shared<TranspositionTable>(0);
+        if (!config.sharedTable->open_shared(config.sharedHash, config.hashMb > 0 ? config.hashMb : TT_DEFAULT_MB)) {
+            return 1;
+        }
+    }
+
+    std::ofstream pgn;
+    if (!options.pgnFile.empty()) {
+        pgn.open(options.pgnFile);
+        if (!pgn) {
+            std::cout << "Unable to open " << options.pgnFile << " for writing" << std::endl;
+            return 1;
+        }
+    }
+
+    const double lowerBound = std::log(options.beta / (1 - options.alpha));
+    const double upperBound = std::log((1 - options.beta) / options.alpha);
+    const std::string date = pgn_date();
+    std::cout << options.engines[0].name << " vs " << options.engines[1].name << ": " << options.games
+              << " games on " << options.concurrency << " threads" << std::endl;
+
+    Tally tally;
+    std::mutex resultMutex;
+    std::atomic<bool> finished(false);
+    std::string verdict;
+    auto startTime = std::chrono::steady_clock::now();
+    {
+        ThreadPool pool(options.concurrency);
+        for (int i = 0; i < options.games; i++) {
+            pool.submit([&, i] {
+                if (finished) return;
+                // Each opening is played twice with colors reversed
+                GameRecord game = play_game(options, openings[(i / 2) % openings.size()], i % 2, i + 1);
+
+                std::lock_guard<std::mutex> lock(resultMutex);
+                if (finished) return;
+                bool whiteWon = game.result == "1-0", blackWon = game.result == "0-1";
+                if (!whiteWon && !blackWon) tally.draws++;
+                else if (whiteWon == (game.whiteEngine == 0)) tally.wins++;
+                else tally.losses++;
+                if (pgn.is_open()) write_pgn(pgn, options, game, date);
+                std::cout << "Game " << game.round << ": " << options.engines[game.whiteEngine].name << " - "
+                          << options.engines[1 - game.whiteEngine].name << " " << game.result << " (" << game.termination
+                          << ")  +" << tally.wins << " =" << tally.draws << " -" << tally.losses << std::endl;
+
+                if (options.sprt) {
+                    double llr = tally.llr(options.elo0, options.elo1);
+                    if (llr >= upperBound || llr <= lowerBound) {
+                        verdict = (llr >= upperBound) ? "H1 accepted" : "H0 accepted";
+                        finished = true;
+                    }
+                }
+            });
+        }
+        pool.wait();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    int n = tally.games();
+    if (n == 0) return 0;
+    double score = tally.score();
+    double margin = 1.96 * std::sqrt(tally.variance() / n);
+    std::cout << "\nResults of " << options.engines[0].name << " vs " << options.engines[1].name << " (" << n
+              << " games, " << seconds << " s)\n"
+              << "W/D/L: " << tally.wins << "/" << tally.draws << "/" << tally.losses << "  score " << score * 100 << "%\n"
+              << "Elo: " << elo_from_score(score) << " +/- " << (elo_from_score(score + margin) - elo_from_score(score - margin)) / 2
+              << " (95%)" << std::endl;
+    if (options.sprt) {
+        std::cout << "SPRT [" << options.elo0 << ", " << options.elo1 << "] alpha=" << options.alpha << " beta=" << options.beta
+                  << ": LLR " << tally.llr(options.elo0, options.elo1) << " [" << lowerBound << ", " << upperBound << "] "
+                  << (verdict.empty() ? "inconclusive" : verdict) << std::endl;
+    }
+    return 0;
+}
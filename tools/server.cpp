@@ -0,0 +1,223 @@
+/** Session server: hosts many independent games behind a Unix-domain socket **/
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+#include "session.h"
+
+const size_t MAX_LINE_LENGTH = 64 * 1024;       // Longer requests close the connection
+const size_t MAX_PENDING_OUTPUT = 1024 * 1024;  // Stop reading from clients that do not read their replies
+
+struct Options {
+    SessionServerOptions server;
+    std::string socketPath = "/tmp/chess.sock";
+    int reportSeconds = 10;  // 0 to only report on exit
+};
+
+/** One client. Workers append replies to `output`; the event loop writes them out. **/
+struct Connection {
+    int fd = -1;
+    std::string input;
+    std::mutex outputMutex;
+    std::string output;
+    bool closed = false;     // Set once the client is gone, so late replies are dropped
+};
+
+static volatile std::sig_atomic_t stopRequested = 0;
+
+static void request_stop(int) {
+    stopRequested = 1;
+}
+
+static void print_usage() {
+    std::cout << "usage: server [options]\n"
+              << "  -socket PATH    Unix-domain socket to listen on (default /tmp/chess.sock)\n"
+              << "  -workers N      searches running at once (default: all cores)\n"
+              << "  -queue N        searches waiting for a worker before requests get \"busy\" (default 256)\n"
+              << "  -movetime MS    default AI time budget per move (default " << SESSION_DEFAULT_MOVETIME_MS << ")\n"
+              << "  -maxtime MS     largest budget a session may ask for (default 10000)\n"
+              << "  -sessions N     maximum number of open sessions (default 100000)\n"
+              << "  -report S       print session and latency statistics every S seconds (0: only on exit)\n"
+              << "Protocol, one request per line: new [MS] [FEN], move ID MOVE, go ID, level ID N, state ID, end ID, stats.\n";
+}
+
+static bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-socket" && hasValue) options.socketPath = argv[++i];
+        else if (arg == "-workers" && hasValue) options.server.workers = std::atoi(argv[++i]);
+        else if (arg == "-queue" && hasValue) options.server.maxQueued = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "-movetime" && hasValue) options.server.defaultMoveTimeMs = std::atoi(argv[++i]);
+        else if (arg == "-maxtime" && hasValue) options.server.maxMoveTimeMs = std::atoi(argv[++i]);
+        else if (arg == "-sessions" && hasValue) options.server.maxSessions = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "-report" && hasValue) options.reportSeconds = std::atoi(argv[++i]);
+        else return false;
+    }
+    return options.server.workers > 0 && options.server.defaultMoveTimeMs > 0;
+}
+
+static int listen_on(const std::string& path) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path " << path << " is too long" << std::endl;
+        return -1;
+    }
+    std::strcpy(address.sun_path, path.c_str());
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    unlink(path.c_str()); // A stale socket from an earlier run would make bind fail
+    if (fd < 0 || bind(fd, (sockaddr*)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        std::cerr << "Unable to listen on " << path << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void print_report(SessionServer& server) {
+    LatencyReport report = server.latency();
+    std::cout << server.session_count() << " sessions, " << report.moves << " AI moves; latency p50 "
+              << report.p50Ms << " ms, p99 " << report.p99Ms << " ms, max " << report.maxMs << " ms" << std::endl;
+}
+
+/** Reads what the client sent and handles every complete line; false once the connection is finished **/
+static bool read_requests(const std::shared_ptr<Connection>& connection, SessionServer& server, int wakeFd) {
+    SessionServer::Reply reply = [connection, wakeFd](const std::string& line) {
+        std::lock_guard<std::mutex> lock(connection->outputMutex);
+        if (connection->closed) return;
+        connection->output += line;
+        connection->output += '\n';
+        char byte = 0;
+        (void)!write(wakeFd, &byte, 1); // Wake the event loop; a full pipe already means it will wake
+    };
+
+    char buffer[16 * 1024];
+    ssize_t bytes = read(connection->fd, buffer, sizeof(buffer));
+    if (bytes == 0 || (bytes < 0 && errno != EAGAIN && errno != EINTR)) return false;
+    if (bytes < 0) return true;
+    connection->input.append(buffer, (size_t)bytes);
+
+    size_t start = 0, end;
+    while ((end = connection->input.find('\n', start)) != std::string::npos) {
+        std::string line = connection->input.substr(start, end - start);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        server.handle(line, reply);
+        start = end + 1;
+    }
+    connection->input.erase(0, start);
+    return connection->input.size() <= MAX_LINE_LENGTH;
+}
+
+/** Writes as much pending output as the socket takes; false if the client has gone **/
+static bool write_replies(Connection& connection) {
+    std::lock_guard<std::mutex> lock(connection.outputMutex);
+    while (!connection.output.empty()) {
+        ssize_t bytes = send(connection.fd, connection.output.data(), connection.output.size(), MSG_NOSIGNAL);
+        if (bytes < 0) return errno == EAGAIN || errno == EINTR;
+        connection.output.erase(0, (size_t)bytes);
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage();
+        return 1;
+    }
+
+    int listenFd = listen_on(options.socketPath);
+    int wakePipe[2];
+    if (listenFd < 0 || pipe2(wakePipe, O_NONBLOCK | O_CLOEXEC) != 0) return 1;
+
+    struct sigaction action = {};
+    action.sa_handler = request_stop; // No SA_RESTART, so poll returns at once
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    std::cout << "Listening on " << options.socketPath << " with " << options.server.workers << " workers" << std::endl;
+    std::map<int, std::shared_ptr<Connection>> connections;
+    {
+        SessionServer server(options.server);
+        auto lastReport = std::chrono::steady_clock::now();
+        std::vector<pollfd> polled;
+        while (!stopRequested) {
+            polled.clear();
+            polled.push_back({ listenFd, POLLIN, 0 });
+            polled.push_back({ wakePipe[0], POLLIN, 0 });
+            for (auto& entry : connections) {
+                Connection& connection = *entry.second;
+                std::lock_guard<std::mutex> lock(connection.outputMutex);
+                short events = (connection.output.size() < MAX_PENDING_OUTPUT) ? POLLIN : 0;
+                if (!connection.output.empty()) events |= POLLOUT;
+                polled.push_back({ connection.fd, events, 0 });
+            }
+            if (poll(polled.data(), polled.size(), 1000) < 0 && errno != EINTR) {
+                std::cerr << "poll failed: " << std::strerror(errno) << std::endl;
+                break;
+            }
+
+            if (polled[0].revents & POLLIN) {
+                int fd;
+                while ((fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                    auto connection = std::make_shared<Connection>();
+                    connection->fd = fd;
+                    connections[fd] = connection;
+                }
+            }
+            if (polled[1].revents & POLLIN) {
+                char drain[256];
+                while (read(wakePipe[0], drain, sizeof(drain)) > 0) {}
+            }
+
+            // Connections accepted above have no pollfd yet and are served on the next pass
+            for (size_t i = 2; i < polled.size(); i++) {
+                std::shared_ptr<Connection> connection = connections[polled[i].fd];
+                bool open = true;
+                if (polled[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                    open = read_requests(connection, server, wakePipe[1]);
+                }
+                if (open) open = write_replies(*connection);
+                if (!open) {
+                    std::lock_guard<std::mutex> lock(connection->outputMutex);
+                    connection->closed = true;
+                    close(connection->fd);
+                    connections.erase(polled[i].fd);
+                }
+            }
+            // Replies queued by workers for connections that were idle in this pass
+            for (auto& entry : connections) {
+                write_replies(*entry.second);
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            if (options.reportSeconds > 0 && now - lastReport >= std::chrono::seconds(options.reportSeconds)) {
+                print_report(server);
+                lastReport = now;
+            }
+        }
+
+        for (auto& entry : connections) {
+            std::lock_guard<std::mutex> lock(entry.second->outputMutex);
+            entry.second->closed = true;
+            close(entry.second->fd);
+        }
+        print_report(server);
+    }
+    close(listenFd);
+    unlink(options.socketPath.c_str());
+    return 0;
+}
@@ -0,0 +1,217 @@
+/** Load generator for the session server: many concurrent AI-vs-AI games, reporting move latency **/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+struct Options {
+    std::string socketPath = "/tmp/chess.sock";
+    int connections = 4;
+    int sessions = 16;       // Games kept in play per connection
+    int seconds = 10;
+    int moveTimeMs = 0;      // 0 for the server's default budget
+};
+
+static void print_usage() {
+    std::cout << "usage: serverload [options]\n"
+              << "  -socket PATH      server socket (default /tmp/chess.sock)\n"
+              << "  -connections N    client connections (default 4)\n"
+              << "  -sessions N       games in play per connection (default 16)\n"
+              << "  -seconds N        test duration (default 10)\n"
+              << "  -movetime MS      time budget requested for each game (default: the server's)\n"
+              << "Every game asks the server for AI moves for both sides until it ends, then starts over;\n"
+              << "the latency of each move request is measured from send to reply.\n";
+}
+
+static bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-socket" && hasValue) options.socketPath = argv[++i];
+        else if (arg == "-connections" && hasValue) options.connections = std::atoi(argv[++i]);
+        else if (arg == "-sessions" && hasValue) options.sessions = std::atoi(argv[++i]);
+        else if (arg == "-seconds" && hasValue) options.seconds = std::atoi(argv[++i]);
+        else if (arg == "-movetime" && hasValue) options.moveTimeMs = std::atoi(argv[++i]);
+        else return false;
+    }
+    return options.connections > 0 && options.sessions > 0;
+}
+
+static int connect_to(const std::string& path) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+/** Buffered line reader and writer over a blocking socket **/
+class LineSocket {
+public:
+    explicit LineSocket(int fd) : fd(fd) {}
+    ~LineSocket() { close(fd); }
+
+    bool send_line(const std::string& line) {
+        std::string data = line + "\n";
+        return send(fd, data.data(), data.size(), MSG_NOSIGNAL) == (ssize_t)data.size();
+    }
+
+    bool read_line(std::string& line) {
+        size_t end;
+        while ((end = buffer.find('\n')) == std::string::npos) {
+            char chunk[4096];
+            ssize_t bytes = recv(fd, chunk, sizeof(chunk), 0);
+            if (bytes <= 0) return false;
+            buffer.append(chunk, (size_t)bytes);
+        }
+        line = buffer.substr(0, end);
+        buffer.erase(0, end + 1);
+        return true;
+    }
+
+private:
+    int fd;
+    std::string buffer;
+};
+
+struct Totals {
+    std::mutex mutex;
+    std::vector<double> latencies;
+    uint64_t games = 0, busy = 0, errors = 0;
+};
+
+using Clock = std::chrono::steady_clock;
+
+/** Keeps `sessions` games going on one connection, with one move request in flight per game **/
+static void run_client(const Options& options, Clock::time_point deadline, Totals& totals) {
+    int fd = connect_to(options.socketPath);
+    if (fd < 0) {
+        std::lock_guard<std::mutex> lock(totals.mutex);
+        totals.errors++;
+        return;
+    }
+    LineSocket socket(fd);
+    std::string newGame = options.moveTimeMs > 0 ? "new " + std::to_string(options.moveTimeMs) : "new";
+    std::map<std::string, Clock::time_point> sent; // Session id -> time of its pending "go"
+    std::vector<double> latencies;
+    uint64_t games = 0, busy = 0, errors = 0;
+    int creating = 0, ending = 0;                  // Requests whose "ok ID" reply is still due
+
+    // Replies arrive in request order per connection, so an "ok" answers the oldest new or end request
+    std::vector<bool> okIsNew;
+    auto start_game = [&]() {
+        creating++;
+        okIsNew.push_back(true);
+        socket.send_line(newGame);
+    };
+    auto end_game = [&](const std::string& id) {
+        sent.erase(id);
+        ending++;
+        okIsNew.push_back(false);
+        socket.send_line("end " + id);
+    };
+    for (int i = 0; i < options.sessions; i++) {
+        start_game();
+    }
+
+    std::string line;
+    while ((!sent.empty() || creating > 0 || ending > 0) && socket.read_line(line)) {
+        std::istringstream reply(line);
+        std::string kind, id, reason;
+        reply >> kind >> id >> reason;
+        if (kind == "ok" || (kind == "error" && id == "-")) {
+            bool isNew = okIsNew.front();
+            okIsNew.erase(okIsNew.begin());
+            (isNew ? creating : ending)--;
+            if (isNew && kind == "ok") {
+                sent[id] = Clock::now();
+                socket.send_line("go " + id);
+            } else if (kind == "error") {
+                errors++;
+            }
+            continue;
+        }
+        auto pending = sent.find(id);
+        if (pending == sent.end()) continue;
+
+        if (kind == "bestmove") {
+            latencies.push_back(std::chrono::duration<double, std::milli>(Clock::now() - pending->second).count());
+        } else if (reason == "busy") {
+            busy++; // Backpressure: wait a little and ask again
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        } else if (reason == "game") {
+            // "game over": start a fresh game in this slot
+            games++;
+            end_game(id);
+            if (Clock::now() < deadline) start_game();
+            continue;
+        } else {
+            errors++;
+            sent.erase(pending);
+            continue;
+        }
+
+        if (Clock::now() >= deadline) {
+            end_game(id);
+        } else {
+            if (kind == "bestmove") pending->second = Clock::now(); // Retries after "busy" count toward the move
+            socket.send_line("go " + id);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(totals.mutex);
+    totals.latencies.insert(totals.latencies.end(), latencies.begin(), latencies.end());
+    totals.games += games;
+    totals.busy += busy;
+    totals.errors += errors;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage();
+        return 1;
+    }
+
+    Totals totals;
+    auto startTime = Clock::now();
+    auto deadline = startTime + std::chrono::seconds(options.seconds);
+    std::vector<std::thread> clients;
+    for (int i = 0; i < options.connections; i++) {
+        clients.emplace_back(run_client, std::cref(options), deadline, std::ref(totals));
+    }
+    for (auto& client : clients) {
+        client.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+
+    std::vector<double>& samples = totals.latencies;
+    if (samples.empty()) {
+        std::cerr << "No moves completed (is the server running on " << options.socketPath << "?)" << std::endl;
+        return 1;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double fraction) {
+        return samples[std::min(samples.size() - 1, (size_t)(fraction * samples.size()))];
+    };
+    std::cout << options.connections * options.sessions << " concurrent games: " << samples.size() << " AI moves in "
+              << seconds << " s (" << samples.size() / seconds << " moves/s), " << totals.games << " games finished\n"
+              << "move latency p50 " << percentile(0.50) << " ms, p99 " << percentile(0.99) << " ms, max "
+              << samples.back() << " ms; " << totals.busy << " busy replies, " << totals.errors << " errors" << std::endl;
+    return 0;
+}
@@ -0,0 +1,122 @@
+/** Microbenchmark of the sliding-piece attack paths: square loop, classical rays, magic and PEXT lookups **/
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "bitboard.h"
+
+struct Query {
+    int square;
+    Bitboard occupied;
+};
+
+/** Walks each direction one square at a time, the way move validation used to **/
+static Bitboard slider_attacks_loop(int square, Bitboard occupied, bool diagonal) {
+    Bitboard attacks = 0;
+    for (int dir = 0; dir < 8; dir++) {
+        bool isDiagonal = DIRECTION_ROW[dir] != 0 && DIRECTION_COL[dir] != 0;
+        if (isDiagonal != diagonal) continue;
+        for (int row = square / 8 + DIRECTION_ROW[dir], col = square % 8 + DIRECTION_COL[dir]; on_board(row, col);
+             row += DIRECTION_ROW[dir], col += DIRECTION_COL[dir]) {
+            attacks |= square_bb(row * 8 + col);
+            if (occupied & square_bb(row * 8 + col)) break;
+        }
+    }
+    return attacks;
+}
+
+/** Runs fn over every query `rounds` times; returns nanoseconds per lookup and accumulates a checksum **/
+template<typename Fn>
+static double time_path(const std::vector<Query>& queries, int rounds, Bitboard& checksum, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    Bitboard sum = 0;
+    for (int round = 0; round < rounds; round++) {
+        for (const Query& query : queries) {
+            sum += fn(query.square, query.occupied ^ sum); // The dependency keeps lookups from overlapping entirely
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    checksum = sum;
+    return 1e9 * seconds / ((double)queries.size() * rounds);
+}
+
+int main(int argc, char* argv[]) {
+    int count = (argc > 1) ? std::atoi(argv[1]) : 100000;
+    int rounds = (argc > 2) ? std::atoi(argv[2]) : 20;
+    if (count <= 0 || rounds <= 0) {
+        std::cout << "usage: sliderbench [queries] [rounds]\n"
+                  << "Times bishop plus rook attack lookups over random occupancies for each available path\n"
+                  << "after checking that all paths agree.\n";
+        return 1;
+    }
+
+    // Random occupancies with about a third of the squares filled, like a middlegame
+    std::vector<Query> queries(count);
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    auto random = [&state]() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    };
+    for (Query& query : queries) {
+        query.square = (int)(random() % 64);
+        query.occupied = random() & random();
+    }
+
+    SliderMode defaultMode = SLIDERS.mode;
+    bool hasPext = pext_supported();
+    for (int square = 0; square < 64; square++) {
+        for (const Query& query : queries) {
+            Bitboard occupied = query.occupied;
+            Bitboard bishop = slider_attacks_loop(square, occupied, true);
+            Bitboard rook = slider_attacks_loop(square, occupied, false);
+            set_slider_mode(SLIDER_MAGIC);
+            bool agree = bishop_attacks_classical(square, occupied) == bishop && rook_attacks_classical(square, occupied) == rook &&
+                         bishop_attacks(square, occupied) == bishop && rook_attacks(square, occupied) == rook;
+            if (hasPext) {
+                set_slider_mode(SLIDER_PEXT);
+                agree = agree && bishop_attacks(square, occupied) == bishop && rook_attacks(square, occupied) == rook;
+            }
+            if (!agree) {
+                std::cout << "Attack paths disagree on square " << square << " with occupancy " << occupied << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    Bitboard checksums[4] = {};
+    double nanos[4] = {};
+    nanos[0] = time_path(queries, rounds, checksums[0], [](int square, Bitboard occupied) {
+        return slider_attacks_loop(square, occupied, true) | slider_attacks_loop(square, occupied, false);
+    });
+    nanos[1] = time_path(queries, rounds, checksums[1], [](int square, Bitboard occupied) {
+        return bishop_attacks_classical(square, occupied) | rook_attacks_classical(square, occupied);
+    });
+    set_slider_mode(SLIDER_MAGIC);
+    nanos[2] = time_path(queries, rounds, checksums[2], [](int square, Bitboard occupied) {
+        return bishop_attacks(square, occupied) | rook_attacks(square, occupied);
+    });
+    if (hasPext) {
+        set_slider_mode(SLIDER_PEXT);
+        nanos[3] = time_path(queries, rounds, checksums[3], [](int square, Bitboard occupied) {
+            return bishop_attacks(square, occupied) | rook_attacks(square, occupied);
+        });
+    }
+    set_slider_mode(defaultMode);
+
+    const char* names[4] = { "loop", "classical", "magic", "pext" };
+    std::cout << count << " queries x " << rounds << " rounds, bishop + rook attacks per lookup\n";
+    for (int path = 0; path < 4; path++) {
+        if (path == 3 && !hasPext) {
+            std::cout << "  pext        not supported by this CPU\n";
+            continue;
+        }
+        std::cout << "  " << names[path] << std::string(12 - std::string(names[path]).size(), ' ') << nanos[path]
+                  << " ns/lookup  (" << nanos[0] / nanos[path] << "x loop)" << (checksums[path] == checksums[0] ? "" : "  MISMATCH")
+                  << "\n";
+    }
+    std::cout << "Default path on this CPU: " << slider_mode_name() << std::endl;
+    return 0;
+}
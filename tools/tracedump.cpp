@@ -0,0 +1,234 @@
+/** Summarizes a search trace: branching factor per ply, cutoff distribution and the largest subtrees **/
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "mapped_file.h"
+#include "movegen.h"
+#include "notation.h"
+#include "trace.h"
+#include "tt.h"
+
+const int TRACE_MAX_PLY = 256;
+const int HOTSPOT_MAX_PLY = 2;           // Subtrees of root moves and of the replies to them
+const char* CUTOFF_BUCKETS[] = { "1st", "2nd", "3rd", "4th-7th", "8th-15th", "16th+" };
+
+struct PlyStats {
+    uint64_t nodes = 0;        // Alpha-beta nodes entered
+    uint64_t qnodes = 0;       // Quiescence nodes
+    uint64_t ttHits = 0;
+    uint64_t expanded = 0;     // Nodes that searched their moves to the end or to a cutoff
+    uint64_t moves = 0;
+    uint64_t cutoffs = 0;
+};
+
+struct Hotspot {
+    uint64_t nodes = 0;
+    int search = 0;
+    int iteration = 0;
+    int depth = 0;
+    int score = 0;
+    int bound = 0;
+    std::vector<PackedMove> path;
+};
+
+/** Reading state of one thread's event stream, which continues from block to block **/
+struct ThreadState {
+    uint64_t counted = 0;                    // Nodes of either kind seen so far
+    uint64_t frameStart[TRACE_MAX_PLY] = {}; // Value of counted when the node at each ply was entered
+    PackedMove path[TRACE_MAX_PLY] = {};     // Move being searched at each ply
+    int search = 0;
+    int iteration = 0;
+};
+
+struct Summary {
+    uint64_t records = 0;
+    uint64_t blocks = 0;
+    int threads = 0;
+    int searches = 0;
+    std::vector<PlyStats> plies = std::vector<PlyStats>(TRACE_MAX_PLY);
+    uint64_t cutoffBuckets[6] = {};
+    std::map<int, std::pair<uint64_t, uint64_t>> iterations; // Depth -> (iterations finished, nodes)
+    std::vector<Hotspot> hotspots;
+    size_t maxHotspots = 10;
+};
+
+static int cutoff_bucket(int index) {
+    return (index < 3) ? index : (index < 7) ? 3 : (index < 15) ? 4 : 5;
+}
+
+static void add_hotspot(Summary& summary, const Hotspot& hotspot) {
+    std::vector<Hotspot>& hotspots = summary.hotspots;
+    if (hotspots.size() < summary.maxHotspots) {
+        hotspots.push_back(hotspot);
+        return;
+    }
+    auto smallest = std::min_element(hotspots.begin(), hotspots.end(),
+                                     [](const Hotspot& a, const Hotspot& b) { return a.nodes < b.nodes; });
+    if (smallest->nodes < hotspot.nodes) *smallest = hotspot;
+}
+
+static void read_record(Summary& summary, ThreadState& state, const TraceRecord& record) {
+    int ply = record.ply;
+    PlyStats& stats = summary.plies[ply];
+    switch (record.event) {
+    case TRACE_SEARCH:
+        state.search = ++summary.searches;
+        break;
+    case TRACE_ITERATION:
+        state.iteration = record.depth;
+        state.frameStart[0] = state.counted;
+        break;
+    case TRACE_ENTER:
+        stats.nodes++;
+        state.frameStart[ply] = state.counted++;
+        break;
+    case TRACE_QUIESCE:
+        stats.qnodes++;
+        state.counted++;
+        break;
+    case TRACE_TT_HIT:
+        stats.ttHits++;
+        break;
+    case TRACE_MOVE:
+        stats.moves++;
+        state.path[ply] = record.move;
+        break;
+    case TRACE_CUTOFF:
+        stats.cutoffs++;
+        summary.cutoffBuckets[cutoff_bucket(record.index)]++;
+        break;
+    case TRACE_EXIT: {
+        uint64_t nodes = state.counted - state.frameStart[ply];
+        if (ply == 0) {
+            auto& iteration = summary.iterations[record.depth];
+            iteration.first++;
+            iteration.second += nodes;
+            break;
+        }
+        stats.expanded++;
+        if (ply <= HOTSPOT_MAX_PLY) {
+            Hotspot hotspot;
+            hotspot.nodes = nodes;
+            hotspot.search = state.search;
+            hotspot.iteration = state.iteration;
+            hotspot.depth = record.depth;
+            hotspot.score = record.score;
+            hotspot.bound = record.index;
+            hotspot.path.assign(state.path, state.path + ply);
+            add_hotspot(summary, hotspot);
+        }
+        break;
+    }
+    }
+}
+
+static void print_usage() {
+    std::cout << "usage: tracedump [-top N] FILE\n"
+              << "Summarizes a trace written with --trace (chess) or -trace (analyze): nodes, table hits,\n"
+              << "cutoffs and branching factor per ply, which move number produced the cutoffs, nodes per\n"
+              << "iteration depth, and the N largest subtrees below the root (default 10).\n";
+}
+
+int main(int argc, char* argv[]) {
+    Summary summary;
+    std::string path;
+    bool valid = true;
+    for (int i = 1; i < argc && valid; i++) {
+        std::string arg = argv[i];
+        if (arg == "-top" && i + 1 < argc) summary.maxHotspots = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg[0] != '-' && path.empty()) path = arg;
+        else valid = false;
+    }
+    if (!valid || path.empty()) {
+        print_usage();
+        return 1;
+    }
+
+    MappedFile file;
+    if (!file.open(path)) return 1;
+    TraceFileHeader header;
+    if (file.size() < sizeof(header)) {
+        std::cout << path << " is not a search trace" << std::endl;
+        return 1;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, TRACE_FILE_MAGIC, sizeof(header.magic)) != 0 || header.version != TRACE_FILE_VERSION ||
+        header.recordSize != sizeof(TraceRecord)) {
+        std::cout << path << " is not a search trace of this version" << std::endl;
+        return 1;
+    }
+
+    std::map<uint32_t, ThreadState> threads;
+    size_t offset = sizeof(header);
+    while (offset + sizeof(TraceBlock) <= file.size()) {
+        TraceBlock block;
+        std::memcpy(&block, file.data() + offset, sizeof(block));
+        offset += sizeof(block);
+        if (offset + (size_t)block.count * sizeof(TraceRecord) > file.size()) {
+            std::cout << "Trace ends in the middle of a block; the rest is ignored" << std::endl;
+            break;
+        }
+        ThreadState& state = threads[block.thread];
+        for (uint32_t i = 0; i < block.count; i++) {
+            TraceRecord record;
+            std::memcpy(&record, file.data() + offset, sizeof(record));
+            offset += sizeof(record);
+            read_record(summary, state, record);
+        }
+        summary.records += block.count;
+        summary.blocks++;
+    }
+    summary.threads = (int)threads.size();
+
+    std::cout << summary.records << " events in " << summary.blocks << " blocks from " << summary.threads
+              << " threads, " << summary.searches << " searches\n\n";
+
+    std::cout << "  ply      nodes     qnodes  tt hit   cut  moves/node\n";
+    uint64_t totalCutoffs = 0;
+    for (int ply = 0; ply < TRACE_MAX_PLY; ply++) {
+        const PlyStats& stats = summary.plies[ply];
+        totalCutoffs += stats.cutoffs;
+        if (stats.nodes == 0 && stats.qnodes == 0 && stats.moves == 0) continue;
+        double entered = (double)std::max<uint64_t>(stats.nodes, 1);
+        std::cout << std::setw(5) << ply << std::setw(11) << stats.nodes << std::setw(11) << stats.qnodes
+                  << std::fixed << std::setprecision(1) << std::setw(7) << 100.0 * stats.ttHits / entered << "%"
+                  << std::setw(5) << (stats.expanded ? 100.0 * stats.cutoffs / stats.expanded : 0.0) << "%"
+                  << std::setprecision(2) << std::setw(12)
+                  << (stats.expanded ? (double)stats.moves / stats.expanded : 0.0) << "\n";
+    }
+
+    std::cout << "\nCutoffs by move number (" << totalCutoffs << " total):";
+    for (int bucket = 0; bucket < 6; bucket++) {
+        std::cout << "  " << CUTOFF_BUCKETS[bucket] << " " << std::setprecision(1)
+                  << 100.0 * summary.cutoffBuckets[bucket] / std::max<uint64_t>(totalCutoffs, 1) << "%";
+    }
+    std::cout << "\n\nNodes per finished iteration (growth is the effective branching factor):\n";
+    double previous = 0;
+    for (const auto& entry : summary.iterations) {
+        double average = (double)entry.second.second / entry.second.first;
+        std::cout << "  depth " << std::setw(2) << entry.first << std::setw(12) << (uint64_t)average;
+        if (previous > 0) std::cout << "  x" << std::setprecision(2) << average / previous;
+        std::cout << "\n";
+        previous = average;
+    }
+
+    std::sort(summary.hotspots.begin(), summary.hotspots.end(),
+              [](const Hotspot& a, const Hotspot& b) { return a.nodes > b.nodes; });
+    std::cout << "\nLargest subtrees:\n";
+    const char* bounds[] = { "", "<=", ">=", "" }; // By Bound: upper and lower bounds, exact scores
+    for (const Hotspot& hotspot : summary.hotspots) {
+        std::string line;
+        for (PackedMove move : hotspot.path) {
+            line += move_to_uci(move) + " ";
+        }
+        std::cout << "  " << std::setw(10) << hotspot.nodes << " nodes  search " << hotspot.search << " iteration "
+                  << hotspot.iteration << "  " << line << "(depth " << hotspot.depth << ", score "
+                  << bounds[std::min(hotspot.bound, 3)] << hotspot.score << ")\n";
+    }
+    return 0;
+}
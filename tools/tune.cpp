@@ -0,0 +1,392 @@
+/** Texel tuner: fits the material evaluation's weights to game results and writes them as include/eval_params.h **/
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ai.h"
+#include "board.h"
+#include "eval.h"
+#include "mapped_file.h"
+#include "movepick.h"
+#include "thread_pool.h"
+
+// Parameters: the five piece values, the two pawn penalties as negative weights, then the passed pawn
+// bonus of each rank. The evaluation is the dot product of these with a position's EvalTerms.
+const int PIECE_PARAMS = 0;            // QUEEN..PAWN, in PieceType order
+const int DOUBLED_PARAM = 5;
+const int ISOLATED_PARAM = 6;
+const int PASSED_PARAMS = 7;           // Ranks 0..7
+const int PARAM_COUNT = 15;
+const int MAX_RESOLVE_PLY = 32;        // Capture sequences end long before this
+const int LOAD_CHUNKS_PER_THREAD = 8;  // Parsing tasks per thread, so uneven chunks still balance
+
+/** One training position, 16 bytes: the terms of its quiet leaf and the game result. Positions sit
+    back to back in one array, so a pass over millions of them streams through memory. **/
+struct TunePosition {
+    int8_t terms[PARAM_COUNT];
+    uint8_t result; // Half points for White: 0, 1 or 2
+};
+static_assert(sizeof(TunePosition) == 16, "TunePosition should fill a quarter of a cache line");
+
+struct Options {
+    int threads = ThreadPool::default_threads();
+    int iterations = 500;
+    double rate = 1.0;        // Adam step size, in centipawns
+    double k = 0;             // Sigmoid scale; 0 fits it to the starting weights
+    int report = 50;          // Iterations between progress lines
+    std::string inputFile;
+    std::string outputFile = "include/eval_params.h";
+};
+
+/** Loss and gradient over a range of positions, before averaging **/
+struct LossSum {
+    double error = 0;
+    double gradient[PARAM_COUNT] = {};
+
+    LossSum& operator+=(const LossSum& other) {
+        error += other.error;
+        for (int i = 0; i < PARAM_COUNT; i++) gradient[i] += other.gradient[i];
+        return *this;
+    }
+};
+
+static void print_usage() {
+    std::cout << "usage: tune [options] positions.txt\n"
+              << "  -threads N      threads for loading and for each pass (default: all cores)\n"
+              << "  -iterations N   gradient steps (default 500)\n"
+              << "  -rate R         step size in centipawns (default 1.0)\n"
+              << "  -k K            sigmoid scale (default: fitted to the starting weights)\n"
+              << "  -report N       iterations between progress lines (default 50)\n"
+              << "  -o FILE         header to write (default include/eval_params.h)\n"
+              << "Each input line is a FEN followed by the game's result, as 1-0, 0-1 or 1/2-1/2 (also inside\n"
+              << "EPD operations such as c9) or as [1.0], [0.5] or [0.0]. Every position is resolved by a capture\n"
+              << "search with the current weights and the weights are fitted to the results of the quiet\n"
+              << "positions it ends in. Rebuild with make afterwards to play with the new weights.\n";
+}
+
+static bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-threads" && hasValue) options.threads = std::atoi(argv[++i]);
+        else if (arg == "-iterations" && hasValue) options.iterations = std::atoi(argv[++i]);
+        else if (arg == "-rate" && hasValue) options.rate = std::atof(argv[++i]);
+        else if (arg == "-k" && hasValue) options.k = std::atof(argv[++i]);
+        else if (arg == "-report" && hasValue) options.report = std::atoi(argv[++i]);
+        else if (arg == "-o" && hasValue) options.outputFile = argv[++i];
+        else if (arg[0] != '-' && options.inputFile.empty()) options.inputFile = arg;
+        else return false;
+    }
+    if (options.inputFile.empty() || options.iterations < 0 || options.rate <= 0) return false;
+    if (options.threads < 1) options.threads = 1;
+    if (options.report < 1) options.report = 1;
+    return true;
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/** The weights the engine was compiled with **/
+static std::vector<double> compiled_params() {
+    std::vector<double> params(PARAM_COUNT);
+    for (int type = QUEEN; type <= PAWN; type++) params[PIECE_PARAMS + type - QUEEN] = PIECE_VALUES[type];
+    params[DOUBLED_PARAM] = -DOUBLED_PAWN_PENALTY;
+    params[ISOLATED_PARAM] = -ISOLATED_PAWN_PENALTY;
+    for (int rank = 0; rank < 8; rank++) params[PASSED_PARAMS + rank] = PASSED_PAWN_BONUS[rank];
+    return params;
+}
+
+static void pack_terms(const EvalTerms& terms, int (&packed)[PARAM_COUNT]) {
+    for (int type = QUEEN; type <= PAWN; type++) packed[PIECE_PARAMS + type - QUEEN] = terms.pieces[type];
+    packed[DOUBLED_PARAM] = terms.doubledPawns;
+    packed[ISOLATED_PARAM] = terms.isolatedPawns;
+    for (int rank = 0; rank < 8; rank++) packed[PASSED_PARAMS + rank] = terms.passedPawns[rank];
+}
+
+/** Capture search with the given weights, as the engine's quiescence search does it; leaf receives the
+    terms of the quiet position the best line ends in. Scores are from the side to move's point of view. **/
+template<Color Us>
+static int resolve(ChessBoard& board, const int* weights, int ply, int alpha, int beta, int (&leaf)[PARAM_COUNT]) {
+    int terms[PARAM_COUNT];
+    pack_terms(evaluation_terms(board), terms);
+    int standPat = 0;
+    for (int i = 0; i < PARAM_COUNT; i++) standPat += weights[i] * terms[i];
+    if (Us == BLACK) standPat = -standPat;
+    if (ply >= MAX_RESOLVE_PLY) {
+        std::copy(terms, terms + PARAM_COUNT, leaf);
+        return standPat;
+    }
+
+    bool inCheck = in_check<Us>(board);
+    int bestEval = -MATE_SCORE;
+    if (!inCheck) {
+        std::copy(terms, terms + PARAM_COUNT, leaf);
+        if (standPat >= beta) return standPat;
+        bestEval = standPat;
+        alpha = std::max(alpha, standPat);
+    }
+
+    const PackedMove noKillers[2] = { NO_MOVE, NO_MOVE };
+    MovePicker<Us> picker = inCheck ? MovePicker<Us>(board, NO_MOVE, noKillers) : MovePicker<Us>(board);
+    bool anyMove = false;
+    for (PackedMove move = picker.next(); move != NO_MOVE; move = picker.next()) {
+        anyMove = true;
+        int childLeaf[PARAM_COUNT];
+        make_move(board, move);
+        int eval = -resolve<opposite(Us)>(board, weights, ply + 1, -beta, -alpha, childLeaf);
+        board.unmake_move();
+        if (eval > bestEval) {
+            bestEval = eval;
+            std::copy(childLeaf, childLeaf + PARAM_COUNT, leaf);
+        }
+        alpha = std::max(alpha, eval);
+        if (beta <= alpha) break;
+    }
+    return (inCheck && !anyMove) ? ply - MATE_SCORE : bestEval;
+}
+
+/** Game result in half points for White, from anywhere after the FEN **/
+static bool parse_result(const std::string& text, uint8_t& result) {
+    if (text.find("1/2-1/2") != std::string::npos) result = 1;
+    else if (text.find("1-0") != std::string::npos) result = 2;
+    else if (text.find("0-1") != std::string::npos) result = 0;
+    else {
+        size_t open = text.find('[');
+        if (open == std::string::npos) return false;
+        char* end;
+        double value = std::strtod(text.c_str() + open + 1, &end);
+        if (end == text.c_str() + open + 1 || (value != 0 && value != 0.5 && value != 1)) return false;
+        result = (uint8_t)(2 * value);
+    }
+    return true;
+}
+
+/** Splits a line into the FEN (four fields and the move counters if present) and the rest **/
+static void split_fen(const std::string& line, std::string& fen, std::string& rest) {
+    std::istringstream stream(line);
+    std::string field;
+    fen.clear();
+    for (int i = 0; i < 4 && stream >> field; i++) fen += (i ? " " : "") + field;
+    std::streampos afterFields = stream.tellg();
+    std::string halfmoves, fullmoves;
+    if (stream >> halfmoves >> fullmoves && halfmoves.find_first_not_of("0123456789") == std::string::npos &&
+        fullmoves.find_first_not_of("0123456789") == std::string::npos) {
+        fen += " " + halfmoves + " " + fullmoves;
+        afterFields = stream.tellg();
+    }
+    rest = (afterFields == std::streampos(-1)) ? "" : line.substr((size_t)afterFields);
+}
+
+/** Parses and resolves the lines that start within [begin, end) of the file **/
+static void load_chunk(const char* data, size_t size, size_t begin, size_t end, const int* weights,
+                       std::vector<TunePosition>& positions, uint64_t& skipped) {
+    // A line belongs to the chunk its first character is in
+    if (begin > 0) {
+        const char* newline = (const char*)std::memchr(data + begin - 1, '\n', size - (begin - 1));
+        begin = newline ? newline - data + 1 : size;
+    }
+    ChessBoard board;
+    std::string fen, rest;
+    while (begin < end) {
+        const char* newline = (const char*)std::memchr(data + begin, '\n', size - begin);
+        size_t lineEnd = newline ? newline - data : size;
+        std::string line(data + begin, lineEnd - begin);
+        begin = lineEnd + 1;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        TunePosition position;
+        split_fen(line, fen, rest);
+        if (!parse_result(rest, position.result) || !board.load_fen(fen)) {
+            skipped++;
+            continue;
+        }
+        int leaf[PARAM_COUNT];
+        int score = (board.sideToMove == WHITE) ? resolve<WHITE>(board, weights, 0, -MATE_SCORE, MATE_SCORE, leaf)
+                                                : resolve<BLACK>(board, weights, 0, -MATE_SCORE, MATE_SCORE, leaf);
+        // Positions the capture search finds mate in have no quiet leaf to learn from
+        if (is_mate_score(score)) {
+            skipped++;
+            continue;
+        }
+        for (int i = 0; i < PARAM_COUNT; i++) position.terms[i] = (int8_t)leaf[i];
+        positions.push_back(position);
+    }
+}
+
+/** Squared error of the predicted score against the result over [begin, end), with its gradient if asked **/
+static void accumulate(const TunePosition* begin, const TunePosition* end, const double* params, double scale,
+                       bool withGradient, LossSum& sum) {
+    for (const TunePosition* position = begin; position != end; position++) {
+        double eval = 0;
+        for (int i = 0; i < PARAM_COUNT; i++) eval += params[i] * position->terms[i];
+        double predicted = 1.0 / (1.0 + std::exp(-scale * eval));
+        double difference = predicted - 0.5 * position->result;
+        sum.error += difference * difference;
+        if (!withGradient) continue;
+        double slope = difference * predicted * (1.0 - predicted);
+        for (int i = 0; i < PARAM_COUNT; i++) sum.gradient[i] += slope * position->terms[i];
+    }
+}
+
+/** Mean error (and gradient) over every position, one contiguous slice per thread **/
+static LossSum evaluate_all(ThreadPool& pool, const std::vector<TunePosition>& positions,
+                            const std::vector<double>& params, double k, bool withGradient) {
+    // The winning probability is 1 / (1 + 10^(-k * eval / 400))
+    double scale = k * std::log(10.0) / 400.0;
+    int slices = pool.size();
+    std::vector<LossSum> sums(slices);
+    for (int slice = 0; slice < slices; slice++) {
+        pool.submit([&, slice] {
+            const TunePosition* base = positions.data();
+            accumulate(base + positions.size() * slice / slices, base + positions.size() * (slice + 1) / slices,
+                       params.data(), scale, withGradient, sums[slice]);
+        });
+    }
+    pool.wait();
+
+    // Summed in slice order, so the result does not depend on which thread finished first
+    LossSum total;
+    for (const LossSum& sum : sums) total += sum;
+    double count = (double)std::max<size_t>(positions.size(), 1);
+    total.error /= count;
+    for (double& gradient : total.gradient) gradient *= 2.0 * scale / count;
+    return total;
+}
+
+/** Golden-section search for the sigmoid scale that best fits the starting weights **/
+static double fit_k(ThreadPool& pool, const std::vector<TunePosition>& positions, const std::vector<double>& params) {
+    const double ratio = (std::sqrt(5.0) - 1) / 2;
+    double low = 0.05, high = 5.0;
+    double a = high - ratio * (high - low), b = low + ratio * (high - low);
+    double errorA = evaluate_all(pool, positions, params, a, false).error;
+    double errorB = evaluate_all(pool, positions, params, b, false).error;
+    for (int i = 0; i < 40; i++) {
+        if (errorA < errorB) {
+            high = b;
+            b = a;
+            errorB = errorA;
+            a = high - ratio * (high - low);
+            errorA = evaluate_all(pool, positions, params, a, false).error;
+        } else {
+            low = a;
+            a = b;
+            errorA = errorB;
+            b = low + ratio * (high - low);
+            errorB = evaluate_all(pool, positions, params, b, false).error;
+        }
+    }
+    return (low + high) / 2;
+}
+
+static bool write_header(const std::string& path, const std::vector<double>& params, size_t positions, double k,
+                         double startError, double error) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cout << "Unable to open " << path << " for writing" << std::endl;
+        return false;
+    }
+    auto weight = [&](int index) { return (int)std::lround(params[index]); };
+    out << "/** Header File holding the Material Evaluation's weights. Generated by tools/tune; regenerate rather than edit. **/\n"
+        << "#ifndef EVAL_PARAMS_H\n"
+        << "#define EVAL_PARAMS_H\n\n"
+        << "// Fitted to " << positions << " positions with K = " << std::fixed << std::setprecision(3) << k
+        << ", mean squared error " << std::setprecision(6) << startError << " -> " << error << "\n\n"
+        << "const int PIECE_VALUES[6] = { 0";
+    for (int type = QUEEN; type <= PAWN; type++) out << ", " << weight(PIECE_PARAMS + type - QUEEN);
+    out << " }; // By PieceType; kings are never traded\n"
+        << "const int DOUBLED_PAWN_PENALTY = " << -weight(DOUBLED_PARAM) << ";\n"
+        << "const int ISOLATED_PAWN_PENALTY = " << -weight(ISOLATED_PARAM) << ";\n"
+        << "const int PASSED_PAWN_BONUS[8] = { ";
+    for (int rank = 0; rank < 8; rank++) out << (rank ? ", " : "") << weight(PASSED_PARAMS + rank);
+    out << " }; // By relative rank (1 = starting rank; 0 and 7 unused)\n\n"
+        << "#endif // EVAL_PARAMS_H\n";
+    return (bool)out;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage();
+        return 1;
+    }
+    MappedFile input;
+    if (!input.open(options.inputFile)) return 1;
+
+    std::vector<double> params = compiled_params();
+    int weights[PARAM_COUNT];
+    for (int i = 0; i < PARAM_COUNT; i++) weights[i] = (int)params[i];
+
+    ThreadPool pool(options.threads);
+    auto startTime = std::chrono::steady_clock::now();
+    std::vector<TunePosition> positions;
+    uint64_t skipped = 0;
+    {
+        // Chunks are parsed and resolved in parallel, then joined in file order
+        size_t chunks = (size_t)pool.size() * LOAD_CHUNKS_PER_THREAD;
+        std::vector<std::vector<TunePosition>> loaded(chunks);
+        std::vector<uint64_t> chunkSkipped(chunks);
+        for (size_t chunk = 0; chunk < chunks; chunk++) {
+            pool.submit([&, chunk] {
+                load_chunk(input.data(), input.size(), input.size() * chunk / chunks, input.size() * (chunk + 1) / chunks,
+                           weights, loaded[chunk], chunkSkipped[chunk]);
+            });
+        }
+        pool.wait();
+        size_t total = 0;
+        for (const auto& chunk : loaded) total += chunk.size();
+        positions.reserve(total);
+        for (size_t chunk = 0; chunk < chunks; chunk++) {
+            positions.insert(positions.end(), loaded[chunk].begin(), loaded[chunk].end());
+            skipped += chunkSkipped[chunk];
+        }
+    }
+    input.close();
+    std::cout << "Loaded " << positions.size() << " positions (" << positions.size() * sizeof(TunePosition) / (1 << 20)
+              << " MB) in " << std::setprecision(3) << seconds_since(startTime) << " s; " << skipped
+              << " lines skipped (no result, invalid or mated)" << std::endl;
+    if (positions.empty()) return 1;
+
+    double k = options.k > 0 ? options.k : fit_k(pool, positions, params);
+    double startError = evaluate_all(pool, positions, params, k, false).error;
+    std::cout << "K = " << std::fixed << std::setprecision(3) << k << ", starting error " << std::setprecision(6)
+              << startError << std::endl;
+
+    // Adam: each weight moves by about the step size per iteration, however differently they are scaled
+    const double beta1 = 0.9, beta2 = 0.999, epsilon = 1e-12;
+    std::vector<double> momentum(PARAM_COUNT), velocity(PARAM_COUNT);
+    double error = startError;
+    auto tuneStart = std::chrono::steady_clock::now();
+    for (int iteration = 1; iteration <= options.iterations; iteration++) {
+        LossSum loss = evaluate_all(pool, positions, params, k, true);
+        error = loss.error;
+        for (int i = 0; i < PARAM_COUNT; i++) {
+            momentum[i] = beta1 * momentum[i] + (1 - beta1) * loss.gradient[i];
+            velocity[i] = beta2 * velocity[i] + (1 - beta2) * loss.gradient[i] * loss.gradient[i];
+            double corrected = momentum[i] / (1 - std::pow(beta1, iteration));
+            double spread = std::sqrt(velocity[i] / (1 - std::pow(beta2, iteration))) + epsilon;
+            params[i] -= options.rate * corrected / spread;
+        }
+        if (iteration % options.report == 0 || iteration == options.iterations) {
+            std::cout << "Iteration " << iteration << ": error " << std::setprecision(6) << error << std::endl;
+        }
+    }
+    double tuneSeconds = seconds_since(tuneStart);
+    error = evaluate_all(pool, positions, params, k, false).error;
+    std::cout << std::setprecision(0) << (tuneSeconds > 0 ? positions.size() * options.iterations / tuneSeconds : 0)
+              << " positions/s per pass on " << pool.size() << " threads; final error " << std::setprecision(6)
+              << error << std::endl;
+
+    if (!write_header(options.outputFile, params, positions.size(), k, startError, error)) return 1;
+    std::cout << "Wrote " << options.outputFile << std::endl;
+    return 0;
+}